@@ -0,0 +1,88 @@
+/**
+ * @file Admission.h
+ * @brief Admission control: bounded LB queues, load shedding and queue timeouts (config.cfg)
+ * @author Bizaco Load Balancer Project
+ */
+
+#ifndef ADMISSION_H
+#define ADMISSION_H
+
+#include "Config.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/** What a full LB does with an arrival */
+enum class AdmissionPolicy {
+    RejectNew,   /**< turn the arrival away */
+    DropOldest,  /**< discard the longest-waiting queued req to make room */
+    Red          /**< random early drop: shed arrivals before the queue is full, more often the fuller it is */
+};
+
+/** What random early drop measures */
+enum class RedSignal {
+    Depth,  /**< reqs waiting in the LB */
+    Age     /**< cycles the longest-waiting queued req has waited */
+};
+
+/** Why a req was shed (log lines and summary counts, in this order) */
+enum class ShedReason : uint8_t { QueueFull, DropOldest, EarlyDrop, Timeout };
+constexpr size_t kShedReasons = 4;
+
+/** @return false if s names no admission policy (p unchanged) */
+bool parseAdmissionPolicy(const std::string& s, AdmissionPolicy& p);
+/** @return false if s names no RED signal (r unchanged) */
+bool parseRedSignal(const std::string& s, RedSignal& r);
+/** "queue-full", "drop-oldest", "early-drop" or "timeout" */
+const char* shedReasonName(ShedReason r);
+
+/**
+ * @class AdmissionControl
+ * @brief Decides, per arrival, whether an LB queues it
+ *
+ * The early-drop coin is counter-based (Philox keyed by the run's seed, indexed by req id),
+ * so the verdicts do not depend on the engine or on how the switch runs its LBs.
+ */
+class AdmissionControl {
+public:
+    /** What happens to an arrival */
+    enum class Verdict {
+        Admit,
+        DropOldest,  /**< admit it after discarding the oldest queued req */
+        QueueFull,   /**< reject it: the queue is at cfg.maxQueueDepth */
+        EarlyDrop    /**< reject it: RED */
+    };
+
+    /** Unknown names in cfg fall back to the defaults (main validates them); the coin is keyed by cfg.seed */
+    explicit AdmissionControl(const Config& cfg);
+
+    /** Key the early-drop coin (the seed a run picked when cfg.seed is 0) */
+    void seed(uint64_t key) { key_ = key; }
+
+    /** false if nothing is ever shed: no depth bound, no RED and no timeout */
+    bool enabled() const { return maxDepth_ > 0 || policy_ == AdmissionPolicy::Red || timeout_ > 0; }
+    /** Cycles a req may wait to start before it is discarded; 0 = no limit */
+    int timeout() const { return timeout_; }
+
+    /**
+     * @param id req id of the arrival
+     * @param depth reqs waiting in the LB (central and server queues)
+     * @param age cycles the longest-waiting queued req has waited (0 if none is queued)
+     */
+    Verdict admit(uint64_t id, size_t depth, int age) const;
+
+    /** One line for run log headers, e.g. "max depth 500, red on depth 250..500 up to 10%" */
+    std::string describe() const;
+
+private:
+    AdmissionPolicy policy_{AdmissionPolicy::RejectNew};
+    RedSignal signal_{RedSignal::Depth};
+    size_t maxDepth_;
+    double redMin_;    /**< signal at which early drops start */
+    double redMax_;    /**< signal at which every arrival is dropped */
+    double maxDrop_;   /**< drop probability just below redMax_ */
+    int timeout_;
+    uint64_t key_;
+};
+
+#endif /* ADMISSION_H */
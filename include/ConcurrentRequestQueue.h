@@ -0,0 +1,65 @@
+/**
+ * @file ConcurrentRequestQueue.h
+ * @brief Lock-free bounded MPMC queue of Requests for the real-time mode
+ * @author Bizaco Load Balancer Project
+ */
+
+#ifndef CONCURRENTREQUESTQUEUE_H
+#define CONCURRENTREQUESTQUEUE_H
+
+#include "Request.h"
+#include <atomic>
+#include <memory>
+#include <cstddef>
+
+/**
+ * @class ConcurrentRequestQueue
+ * @brief Bounded multi-producer / multi-consumer ring of Requests (held by value)
+ *
+ * Each cell carries a sequence number telling producers and consumers whose turn it is,
+ * so enqueue and dequeue are one CAS on their own position counter plus a copy; no locks.
+ * Capacity is rounded up to a power of two and fixed at construction.
+ */
+class ConcurrentRequestQueue {
+public:
+    /**
+     * @param capacity Minimum number of reqs the queue can hold
+     */
+    explicit ConcurrentRequestQueue(size_t capacity);
+
+    ConcurrentRequestQueue(const ConcurrentRequestQueue&) = delete;
+    ConcurrentRequestQueue& operator=(const ConcurrentRequestQueue&) = delete;
+
+    /**
+     * Add a req to the back of the queue
+     * @param r req to copy in
+     * @return false if the queue is full
+     */
+    bool try_enqueue(const Request& r);
+
+    /**
+     * Remove the front req
+     * @param out req to fill
+     * @return false if the queue is empty
+     */
+    bool try_dequeue(Request& out);
+
+    /** Number of reqs queued; exact only while no other thread is using the queue */
+    size_t size_approx() const;
+
+    /** Number of reqs the queue can hold */
+    size_t capacity() const;
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        Request req;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> enqueuePos_{0};  /**< own cache lines: written by */
+    alignas(64) std::atomic<size_t> dequeuePos_{0};  /**< producers and consumers separately */
+};
+
+#endif /* CONCURRENTREQUESTQUEUE_H */
@@ -22,13 +22,65 @@ struct Config {
     int initialQueueSize{1000};   /**< typically servers * 100 */
     int lowFactor{50};            /**< Scale down if queue < lowFactor * servers */
     int highFactor{80};          /**< Scale up if queue > highFactor * servers */
+    int maxServers{100};         /**< Scale-up ceiling on active servers */
+    std::vector<std::string> serverClasses;  /**< name:count:slots:speed; empty = initialServers 1-slot servers */
+    std::string scaler{"threshold"};  /**< "threshold" (low/highFactor) or "predictive" (rate-based target) */
+    int scaleTargetUtilization{80};   /**< predictive: busy share the target capacity aims for (percent) */
+    int scaleSmoothingPercent{30};    /**< predictive: EWMA weight of the newest window (percent) */
+    int scaleDrainCycles{500};        /**< predictive: cycles within which a backlog should be cleared */
+    int scaleMaxStep{0};              /**< predictive: servers added / removed per decision; 0 = any */
+    int provisionDelay{0};            /**< cycles an added server warms up before it takes work */
     int minServiceTime{1};
     int maxServiceTime{50};
     int newRequestProbabilityPercent{5};  /**< per-cycle probability of adding a new req (0-100) */
+    std::string arrivalProcess{"bernoulli"};  /**< bernoulli (newRequestProbabilityPercent), poisson, mmpp, diurnal */
+    double arrivalRate{0};        /**< poisson / mmpp calm / diurnal mean arrivals per cycle; 0 = newRequestProbabilityPercent / 100 */
+    double burstRate{0};          /**< mmpp: arrivals per cycle in a burst; 0 = 10 x arrivalRate */
+    int calmCycles{2000};         /**< mmpp: mean length of a calm spell */
+    int burstCycles{200};         /**< mmpp: mean length of a burst */
+    int diurnalPeriod{0};         /**< diurnal: cycles per rate cycle; 0 = runTime */
+    int diurnalAmplitudePercent{80};  /**< diurnal: swing of the rate around arrivalRate */
+    std::string serviceDistribution{"uniform"};  /**< uniform, exponential, lognormal, pareto; clamped to [min, maxServiceTime] */
+    double serviceMean{0};        /**< exponential / lognormal / pareto mean; 0 = (min + maxServiceTime) / 2 */
+    double serviceSigma{1.0};     /**< lognormal: sigma of log(service time) */
+    double paretoAlpha{1.5};      /**< pareto: tail index (smaller = heavier) */
+    std::string queueDiscipline{"fifo"};  /**< central queue order: fifo, priority, sjf, edf, wfq (central-queue dispatch only) */
+    std::string priorityJobType{"S"};  /**< priority: job type (S or P) served first */
+    int streamingDeadline{50};    /**< edf: cycles an S req may wait before it is late */
+    int processingDeadline{500};  /**< edf: cycles a P req may wait before it is late */
+    int streamingWeight{1};       /**< wfq: share of service time for S reqs */
+    int processingWeight{1};      /**< wfq: share of service time for P reqs */
+    int maxQueueDepth{0};         /**< reqs an LB may hold waiting (central plus server queues); 0 = unbounded */
+    std::string admissionPolicy{"reject-new"};  /**< when full: reject-new, drop-oldest; red also drops early */
+    std::string redSignal{"depth"};  /**< red: depth (reqs waiting) or age (cycles the oldest req has waited) */
+    int redMin{0};                /**< red: signal at which early drops start; 0 = redMax / 2 */
+    int redMax{0};                /**< red: signal at which every arrival is dropped; 0 = maxQueueDepth / queueTimeout */
+    int redMaxDropPercent{10};    /**< red: drop probability just below redMax */
+    int queueTimeout{0};          /**< discard reqs that waited longer than this many cycles; 0 = never */
+    int generatorThreads{0};      /**< threads drawing large initial queues; 0 = one per core (same reqs either way) */
     unsigned int seed{0};         /**< 0 = use time-based seed */
+    std::string engine{"cycle"};  /**< "cycle" = step every cycle, "event" = jump between events */
+    std::string dispatch{"lowest-idle"};  /**< lowest-idle, round-robin, least-work, power-of-two, jiq */
+    int dispatchQueueLimit{2};    /**< jiq: reqs a busy server may hold waiting */
+    bool parallelSwitch{true};    /**< switch mode: run each LB on its own thread */
+    bool realtime{false};         /**< run on real threads instead of simulated cycles */
+    int threads{0};               /**< real-time worker threads (servers); 0 = initialServers */
+    int producers{1};             /**< real-time threads generating reqs */
+    int workPerUnit{1000};        /**< real-time busy-loop iterations per unit of service time */
+    int realtimeQueueCapacity{65536};  /**< bound of the real-time queue (raised to fit the initial queue) */
+    std::string traceFile;        /**< replay reqs from this JSONL / binary trace instead of generating them */
+    std::string sweepPath;        /**< parameter sweep file (--sweep) */
+    int sweepThreads{0};          /**< sweep pool size; 0 = one per core */
     std::string configPath;
     std::string logPath;
+    std::string logLevel{"all"};  /**< all, scale (scale events only), summary (header + summary), none */
+    std::string logFormat{"text"};  /**< text, or binary (decode with lbdecode) */
+    int metricsInterval{0};       /**< sample LB state every N cycles; 0 = off */
+    std::string metricsFormat{"csv"};  /**< csv or prom (Prometheus text format) */
+    std::string metricsPath;      /**< default: next to the run log */
     std::vector<std::string> blockedRanges;  /**< IP or CIDR ranges to block */
+    std::vector<std::string> allowedRanges;  /**< ranges exempted from a shorter blocked prefix */
+    std::string blocklistFile;               /**< plain-text feed, one prefix per line */
 
     /**
      * Load configuration from a file (key=value, one per line)
@@ -37,6 +89,14 @@ struct Config {
      */
     bool loadFromFile(const std::string& path);
 
+    /**
+     * Set one parameter by its config-file key (e.g. "initialServers", "10")
+     * @param key Config key
+     * @param val Value text; an unparsable number leaves the current value
+     * @return false if the key is unknown
+     */
+    bool set(const std::string& key, const std::string& val);
+
     /**
      * Apply command-line overrides (for example, --servers 10 --runtime 10000)
      * @param argc Argument count
@@ -0,0 +1,85 @@
+/**
+ * @file DispatchPolicy.h
+ * @brief How the LB hands queued reqs to servers (--dispatch)
+ * @author Bizaco Load Balancer Project
+ */
+
+#ifndef DISPATCHPOLICY_H
+#define DISPATCHPOLICY_H
+
+#include "Config.h"
+#include "Request.h"
+#include "ServerSet.h"
+#include "WebServer.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+
+/**
+ * @class DispatchPolicy
+ * @brief Picks the server for each req; keeps whatever per-server state it needs
+ *
+ * Central-queue policies leave reqs in the LB queue until a server has a free slot and
+ * pick which one takes the oldest req (pickIdle); the LB offers the fastest server class
+ * with a free slot first. Server-queue policies route each req to a server as soon as
+ * it is queued (route), weighing servers by capacity (slots x speed); a full server
+ * keeps it in its own FIFO and starts it when a slot frees up. The LB reports server
+ * changes through serverAdded / serverRemoved / requestDone / requestDropped.
+ */
+class DispatchPolicy {
+public:
+    virtual ~DispatchPolicy() = default;
+
+    /** Reseed the policy's own random draws with the run's seed (randomized policies only) */
+    virtual void seed(unsigned int seed) { (void)seed; }
+
+    /** true if reqs wait in per-server queues (route), false for the central queue (pickIdle) */
+    virtual bool usesServerQueues() const = 0;
+
+    /** Central queue: server with a free slot to start the oldest queued req (idle is never empty) */
+    virtual long pickIdle(const ServerSet& idle) { return idle.first(); }
+
+    /**
+     * Server queues: server that gets this req, or -1 to leave it (and every req behind
+     * it) in the central queue until a server next goes idle
+     */
+    virtual long route(const Request& r, int currentTime) {
+        (void)r;
+        (void)currentTime;
+        return -1;
+    }
+
+    /**
+     * Server i takes reqs from currentTime: a fresh or reused slot (idle), or a draining
+     * server kept on (it may still hold reqs)
+     */
+    virtual void serverAdded(size_t i, const WebServer& s, int currentTime) {
+        (void)i;
+        (void)s;
+        (void)currentTime;
+    }
+
+    /** Server i was scaled down: route nothing more to it (it may still be draining its queue) */
+    virtual void serverRemoved(size_t i) { (void)i; }
+
+    /** Server i completed a req; idle is true if the freed slot has nothing else to run */
+    virtual void requestDone(size_t i, bool idle) {
+        (void)i;
+        (void)idle;
+    }
+
+    /** A req routed to server i was discarded from its queue before it started (admission control) */
+    virtual void requestDropped(size_t i, const Request& r) {
+        (void)i;
+        (void)r;
+    }
+};
+
+/**
+ * Build the policy named by cfg.dispatch: lowest-idle (default), round-robin,
+ * least-work, power-of-two or jiq
+ * @return nullptr if the name is unknown
+ */
+std::unique_ptr<DispatchPolicy> makeDispatchPolicy(const Config& cfg);
+
+#endif /* DISPATCHPOLICY_H */
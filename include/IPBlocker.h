@@ -9,13 +9,31 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
+#include <cstddef>
 
 /**
  * @class IPBlocker
  * @brief Blocks IPs that fall within configured ranges
+ *
+ * Rules are CIDR prefixes with a deny or allow action; the longest matching prefix
+ * wins and an address matching no rule is allowed. Rules are compiled into a sorted
+ * table of disjoint blocked intervals (binary search). Large rule sets (e.g. threat
+ * feeds) additionally get a DIR-24-8 table: one 2^24 entry first level indexed by the
+ * top 24 bits, plus 256-bit second-level groups for /25../32 prefixes, so a lookup is
+ * at most two memory reads.
  */
 class IPBlocker {
 public:
+    /** Action of a rule; the longest matching prefix decides */
+    enum class Action : uint8_t { Deny = 0, Allow = 1 };
+
+    /** Rule count at which the DIR-24-8 table is built (it costs 64MB) */
+    static constexpr size_t kLpmTableMinRules = 4096;
+
+    /** Blocked-interval count up to which filterBatch tests every interval in SIMD lanes */
+    static constexpr size_t kSimdMaxIntervals = 32;
+
     IPBlocker() = default;
 
     /**
@@ -24,6 +42,34 @@ public:
      */
     void addBlockedRange(const std::string& cidrOrIp);
 
+    /**
+     * Block several ranges, compiling the table once
+     * @param ranges CIDR strings or single IPs
+     */
+    void addBlockedRanges(const std::vector<std::string>& ranges);
+
+    /**
+     * Allow a range inside a larger blocked one (e.g. "10.1.0.0/16" under "10.0.0.0/8")
+     * @param cidrOrIp CIDR string or single IP
+     */
+    void addAllowedRange(const std::string& cidrOrIp);
+
+    /**
+     * Allow several ranges, compiling the table once
+     * @param ranges CIDR strings or single IPs
+     */
+    void addAllowedRanges(const std::vector<std::string>& ranges);
+
+    /**
+     * Bulk-load a plain-text feed: one prefix per line, optionally preceded by
+     * "deny" / "allow" (or "!" for allow); '#' and ';' start comments.
+     * The file is streamed in large blocks and the table is compiled once at the end.
+     * @param path Path to feed file
+     * @param loaded If non-null, receives the number of rules read
+     * @return true if the file could be read
+     */
+    bool loadBlocklistFile(const std::string& path, size_t* loaded = nullptr);
+
     /**
      * Check if the given IP is blocked
      * @param ip IPv4 address string
@@ -31,17 +77,77 @@ public:
      */
     bool isBlocked(const std::string& ip) const;
 
+    /**
+     * Check if the given packed IP (a.b.c.d == a<<24 | b<<16 | c<<8 | d) is blocked
+     * @param ip IPv4 address in host byte order
+     * @return true if the IP is blocked
+     */
+    bool isBlocked(uint32_t ip) const;
+
+    /**
+     * Check a block of packed IPs in one call. Small rule sets are compared 8 (AVX2)
+     * or 4 (SSE2) addresses at a time; the DIR-24-8 table is probed with AVX2 gathers.
+     * @param ips addresses to check
+     * @param count number of addresses
+     * @param blocked output bitmask of (count + 63) / 64 words; bit i set if ips[i] is blocked
+     */
+    void filterBatch(const uint32_t* ips, size_t count, uint64_t* blocked) const;
+
     /**
      * Get list of blocked ranges for logging
      */
     const std::vector<std::string>& getBlockedRanges() const;
 
+    /**
+     * Get list of allowed ranges for logging
+     */
+    const std::vector<std::string>& getAllowedRanges() const;
+
+    /** Number of compiled rules (config ranges plus feed entries) */
+    size_t ruleCount() const;
+
+    /**
+     * Parse dotted-quad "a.b.c.d" into a packed address
+     * @param ip IPv4 address string
+     * @param out packed address (unchanged on failure)
+     * @return true if ip is a well-formed address
+     */
+    static bool parseIp(const std::string& ip, uint32_t& out);
+
+    /**
+     * Format a packed address back into dotted-quad form
+     */
+    static std::string ipToString(uint32_t ip);
+
 private:
+    /** Closed interval [lo, hi] of blocked addresses */
+    struct Interval {
+        uint32_t lo;
+        uint32_t hi;
+    };
+
+    /** One prefix rule; base is already masked to len bits */
+    struct Rule {
+        uint32_t base;
+        uint8_t len;
+        Action action;
+    };
+
     std::vector<std::string> blockedRanges_;
+    std::vector<std::string> allowedRanges_;
+    std::vector<Rule> rules_;          /**< in insertion order; a later duplicate prefix wins */
+    std::vector<Interval> intervals_;  /**< sorted by lo, disjoint and non-adjacent */
+    std::vector<uint32_t> tbl24_;      /**< 0 = allowed, 1 = blocked, n >= 2 = tbl8 group n-2 */
+    std::vector<uint64_t> tbl8_;       /**< 4 words (256 bits, 1 = blocked) per group */
+    std::vector<uint32_t> simdLo_;     /**< interval starts, when at most kSimdMaxIntervals */
+    std::vector<uint32_t> simdSpan_;   /**< (hi - lo) ^ 0x80000000, for signed lane compares */
 
-    /** Parse "a.b.c.d" or "a.b.c.d/n" and check if ip matches */
-    static bool ipMatchesRange(const std::string& ip, const std::string& range);
-    static unsigned int ipToInt(const std::string& ip);
+    /** Parse "a.b.c.d" or "a.b.c.d/n" from [p, end) into a masked rule */
+    static bool parseRule(const char* p, const char* end, Action action, Rule& out);
+    void addRange(const std::string& cidrOrIp, Action action);
+    void rebuild();
+    void buildIntervals(const std::vector<Rule>& sorted);
+    void buildLpmTable(const std::vector<Rule>& byLength);
 };
 
 #endif /* IPBLOCKER_H */
@@ -0,0 +1,73 @@
+/**
+ * @file LatencyHistogram.h
+ * @brief Log-bucketed (HDR-style) histogram of per-req latencies in cycles
+ * @author Bizaco Load Balancer Project
+ */
+
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+/**
+ * @class LatencyHistogram
+ * @brief Fixed-size histogram with O(1) recording and ~1.6% worst-case relative error
+ *
+ * Values below 128 get a bucket each; every power-of-two range above that is split
+ * into 64 equal buckets, up to 2^31. Percentiles report the top of the bucket the
+ * rank falls in (capped at the exact max), so they never understate a latency.
+ */
+class LatencyHistogram {
+public:
+    /** Record one latency (negative values count as 0) */
+    void record(int64_t v) {
+        if (v < 0) v = 0;
+        counts_[bucketOf(v)]++;
+        count_++;
+        sum_ += static_cast<uint64_t>(v);
+        if (v > max_) max_ = v;
+    }
+
+    /** Add every sample of another histogram */
+    void merge(const LatencyHistogram& other);
+
+    uint64_t count() const { return count_; }
+    int64_t max() const { return max_; }
+    double mean() const { return count_ ? static_cast<double>(sum_) / static_cast<double>(count_) : 0; }
+
+    /**
+     * Latency at or below which pct percent of the samples fall (0 if empty)
+     * @param pct percentile in (0, 100]
+     */
+    int64_t percentile(double pct) const;
+
+    /** Write "p50 a p90 b p99 c p99.9 d max e mean f (n=N)" */
+    void writeTo(std::ostream& os) const;
+
+private:
+    static constexpr int kSubBits = 7;                    /**< 2^7 exact values, 64 buckets per octave above */
+    static constexpr int64_t kExact = int64_t{1} << kSubBits;
+    static constexpr int64_t kHalf = kExact / 2;
+    static constexpr int kMaxBits = 31;                   /**< larger values share the last bucket */
+    static constexpr size_t kBuckets = static_cast<size_t>(kExact + (kMaxBits - kSubBits) * kHalf);
+
+    std::array<uint64_t, kBuckets> counts_{};
+    uint64_t count_{0};
+    uint64_t sum_{0};
+    int64_t max_{0};
+
+    static size_t bucketOf(int64_t v) {
+        if (v < kExact) return static_cast<size_t>(v);
+        int msb = 63 - __builtin_clzll(static_cast<unsigned long long>(v));
+        if (msb >= kMaxBits) return kBuckets - 1;
+        int shift = msb - kSubBits + 1;
+        return static_cast<size_t>(kExact + (shift - 1) * kHalf + ((v >> shift) - kHalf));
+    }
+
+    /** Largest value that falls in bucket i */
+    static int64_t bucketTop(size_t i);
+};
+
+#endif /* LATENCYHISTOGRAM_H */
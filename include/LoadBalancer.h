@@ -8,15 +8,30 @@
 #define LOADBALANCER_H
 
 #include "Config.h"
+#include "Admission.h"
 #include "Request.h"
 #include "RequestQueue.h"
+#include "RequestPool.h"
+#include "SchedulingQueue.h"
 #include "WebServer.h"
 #include "IPBlocker.h"
+#include "ServerSet.h"
+#include "LogSink.h"
+#include "LatencyHistogram.h"
+#include "MetricsSeries.h"
+#include "DispatchPolicy.h"
+#include "Trace.h"
+#include "Workload.h"
+#include <array>
 #include <vector>
 #include <memory>
 #include <ostream>
-#include <fstream>
-#include <random>
+#include <queue>
+#include <utility>
+#include <functional>
+#include <deque>
+#include <string>
+#include <tuple>
 
 /**
  * @class LoadBalancer
@@ -24,48 +39,129 @@
  */
 class LoadBalancer {
 public:
+    /** End-of-run figures, as reported by writeSummaryTo */
+    struct Metrics {
+        size_t generated{0};
+        size_t completed{0};
+        size_t blocked{0};
+        size_t rejected{0};       /**< shed by admission control, whatever the reason */
+        std::array<size_t, kShedReasons> shed{};  /**< rejected by ShedReason */
+        size_t endQueue{0};
+        size_t peakQueue{0};
+        int peakQueueCycle{0};
+        double avgQueue{0};
+        double utilization{0};   /**< percent: busy / provisioned server-cycles */
+        long long serverCycles{0};  /**< provisioned: sum over cycles of active, warming and draining servers */
+        long long busyCycles{0};    /**< server-cycles spent on a req */
+        long long warmingCycles{0}; /**< server-cycles spent warming up */
+        double avgActiveServers{0};
+        long long waitP99{0};       /**< cycles from arrival to assignment, 99th percentile */
+        int activeServers{0};
+        int serverSlots{0};         /**< servers ever allocated at once: slots are reused */
+        /** Per server class, in cfg.serverClasses order */
+        struct Class {
+            std::string name;
+            int slots{1};
+            double speed{1.0};
+            int servers{0};          /**< provisioned at the end */
+            long long slotCycles{0}; /**< provisioned */
+            long long busyCycles{0};
+        };
+        std::vector<Class> classes;
+        int scaleUps{0};
+        int scaleDowns{0};
+    };
+
     explicit LoadBalancer(const Config& cfg);
 
     /**
-     * Add 1 web server to pool
+     * Add 1 web server to pool (scaleIfNeeded stops at cfg.maxServers servers), of the
+     * server class furthest below its share of the fleet. A draining server of that class
+     * is kept on if there is one; otherwise a free slot is reused (or a new one allocated)
+     * and warms up for cfg.provisionDelay cycles before taking reqs.
      */
     void addServer();
 
     /**
-     * Remove 1 web server (oldest /least busy). Does not go below 1.
+     * Remove 1 web server: a warming one first, then the highest-numbered idle one, else
+     * the busy one with the least work left drains. Does not go below 1.
+     * @return false if nothing could be removed
      */
-    void removeServer();
+    bool removeServer();
 
     /**
      * Run the full sim for cfg.runTime cycles & write logs
      */
     void runSimulation();
 
+    /**
+     * Run the same workload on real threads: cfg.producers threads generate reqs into a
+     * lock-free bounded queue and one worker thread per server pulls them, spinning
+     * cfg.workPerUnit iterations per unit of service time. No per-req log lines and no
+     * scaling; writes the usual summary plus wall-clock throughput and contention figures.
+     */
+    void runRealtime();
+
     /**
      * Set output stream for colored console output (optional). If null, no console logging
      */
     void setLogStream(std::ostream* os);
+    /** Open the run log at path (cfg.logLevel decides what is written; "none" opens nothing) */
     void setLogFile(const std::string& path);
 
     /**
-     * Generate initial queue (initialQueueSize reqs). Called automatically at start of runSimulation()
+     * Generate initial queue (initialQueueSize reqs, drawn on cfg.generatorThreads threads).
+     * Called automatically at start of runSimulation()
+     */
+    void generateInitialQueue();
+
+    /**
+     * Replay reqs from a trace instead of generating them: records arriving at cycle 0
+     * (or before) form the initial queue, the rest arrive at their cycle. The trace is
+     * streamed, so it may be far larger than memory.
+     * @return false if it cannot be opened (getTrace()->error() says why)
      */
-    void generateInitialQueue(std::mt19937& rng);
+    bool openTrace(const std::string& path);
+    /** The trace being replayed, or nullptr; check error() after the run */
+    const TraceReader* getTrace() const { return trace_.get(); }
 
     /** Access IP blocker to add blocked ranges (e.g. before runSimulation) */
     IPBlocker& getIPBlocker() { return ipBlocker_; }
+    /** Filter with a blocker owned elsewhere instead (a sweep shares one); it must outlive the run */
+    void shareIPBlocker(const IPBlocker& blocker) { sharedBlocker_ = &blocker; }
 
     /**
-     * Enqueue a req (used by Switch when routing by job type)
+     * Enqueue a req (used by Switch when routing by job type); admission control may shed
+     * it, or the oldest queued req to make room
      */
     void enqueueRequest(const Request& r);
 
+    /** Seed the LB's own random draws: early-drop coin and dispatch policy (Switch, with the seed it picked) */
+    void seed(unsigned int seed);
+
+    /** Take the reqs queued so far as the starting queue (Switch, once it has routed its initial queue) */
+    void markStartingQueue();
+
     /**
      * Run one sim cycle at the given time (no new req generation)
      * Used when driven by Switch for concurrent multi-LB simulation.
      */
     void runOneCycleAt(int currentTime);
 
+    /**
+     * Earliest cycle after the last one run at which this LB's state can change on its
+     * own (a completion, a free server with queued work, or a scale check that may act).
+     * New arrivals are not included. Used by the event engine to skip idle cycles.
+     */
+    int nextEventTime() const;
+
+    /**
+     * Account for the idle cycles skipped between the last cycle run and the given one
+     * (event engine only; a no-op when every cycle is run). Call it before enqueuing
+     * reqs that arrive at that cycle, and with runTime once the run is over.
+     */
+    void skipTo(int cycle);
+
     /**
      * Write summary to an output stream (e.g. for Switch combined log)
      * @param os Output stream
@@ -73,19 +169,65 @@ public:
      */
     void writeSummaryTo(std::ostream& os, const std::string& namePrefix = "") const;
 
-    /** Current queue size (for stats) */
+    /** Current queue size: central queue plus server queues (for stats) */
     size_t getQueueSize() const;
     /** Total reqs completed by this LB. */
     size_t getTotalCompleted() const;
-    /** Total reqs that entered this LB (enqueued). */
+    /** Total reqs that reached this LB past the IP blocker, shed ones included. */
     size_t getTotalGenerated() const;
+    /** Summary figures of the run so far (e.g. for parameter sweeps) */
+    Metrics getMetrics() const;
+    /** Queueing delay of every dispatched req: assign cycle - arrival cycle */
+    const LatencyHistogram& getWaitHistogram() const { return waitHist_; }
+    /** Time in system of every completed req: completion cycle - arrival cycle */
+    const LatencyHistogram& getSojournHistogram() const { return sojournHist_; }
+    /** Wait of every req discarded from the queue (drop-oldest, timeout) */
+    const LatencyHistogram& getShedWaitHistogram() const { return shedWaitHist_; }
+    /** State sampled every cfg.metricsInterval cycles (empty when off or in real-time mode) */
+    const MetricsSeries& getMetricsSeries() const { return metrics_; }
+
+    /**
+     * Write the sampled series (cfg.metricsFormat) to path
+     * @return false if the file cannot be written
+     */
+    bool writeMetrics(const std::string& path) const;
 
 private:
     Config cfg_;
-    RequestQueue rQ_;
-    std::vector<std::unique_ptr<WebServer>> servers_;
+    Workload workload_;
+    AdmissionControl admission_;
+    Workload::Batch arrivals_;  /**< scratch: reqs being generated */
+    RequestPool pool_;
+    SchedulingQueue rQ_;
+    std::vector<std::unique_ptr<WebServer>> servers_;  /**< slots; inactive ones are reused */
+    std::vector<ServerClass> classes_;
+    std::vector<int> classOrder_;      /**< class indices, fastest first */
+    std::vector<int> classServers_;    /**< provisioned servers per class */
+    ServerSet idle_;      /**< indices of active servers with a free slot */
+    std::vector<ServerSet> idleByClass_;  /**< idle_ split by class */
+    size_t freeSlots_{0};  /**< free slots over idle_ */
+    long long capacityMilli_{0};  /**< slots x speed x 1000 over active and warming servers */
+    ServerSet free_;      /**< inactive slots */
+    ServerSet draining_;  /**< scaled down, finishing their work */
+    std::deque<std::pair<int, size_t>> warming_;  /**< (ready cycle, slot) in provisioning order */
+    /** (busyUntil, server, slot) of every running req, earliest completion on top */
+    using Running = std::tuple<int, int, int>;
+    std::priority_queue<Running, std::vector<Running>, std::greater<Running>> busy_;
+    std::vector<std::pair<int, int>> done_;  /**< scratch: (server, slot) completing this cycle */
+    std::vector<RequestHandle> batch_;  /**< scratch: reqs dispatched this cycle */
+    std::unique_ptr<DispatchPolicy> policy_;
+    std::vector<RequestQueue> serverQ_;  /**< server-queue policies: reqs routed to server i, not started */
+    size_t serverQueued_{0};             /**< total over serverQ_ */
+    bool routeBlocked_{false};           /**< the policy turned the oldest req away; wait for a free server */
+    /** Admission control with server queues: (req id, server) of reqs queued at a server, in
+     *  routing order (arrival order); entries of started reqs are dropped when they reach the front */
+    std::deque<std::pair<int, size_t>> routed_;
+    int activeCount_{0};  /**< servers taking reqs (warming and draining ones excluded) */
     IPBlocker ipBlocker_;
+    const IPBlocker* sharedBlocker_{nullptr};  /**< used instead of ipBlocker_ when set */
+    std::unique_ptr<TraceReader> trace_;
     int cT_{0};
+    int lastCycle_{-1};   /**< last cycle actually run (the event engine skips idle ones) */
     int lST_{-9999};
     int nextRequestId_{1};
     size_t initialQueueSize_ = 0;
@@ -95,24 +237,69 @@ private:
     size_t totCompleted_{0};
     size_t totalBlocked_{0};
     size_t totRejected_{0};
+    std::array<size_t, kShedReasons> shed_{};  /**< totRejected_ by ShedReason */
     size_t pQS_{0};
     int pQC_{0};
     size_t sumQueueSize_{0};
+    size_t queueSamples_{0};  /**< real-time queue depth samples (0 = one per cycle) */
     int scaleUpCount_{0};
     int scaleDownCount_{0};
+    double realtimeBusy_{0};  /**< real-time runs: worker busy percent */
+
+    /** Predictive scaler (cfg.scaler == "predictive") */
+    bool predictive_{false};
+    double rateEwma_{-1};        /**< arrivals per cycle; < 0 until the first full window */
+    double svcEwma_{-1};         /**< mean service time of arrivals; < 0 until one arrives */
+    size_t windowArrivals_{0};   /**< since the last plan */
+    long long windowWork_{0};    /**< service time of those arrivals */
+    int lastPlan_{-1};
+    LatencyHistogram waitHist_;
+    LatencyHistogram sojournHist_;
+    LatencyHistogram shedWaitHist_;
+    LatencyHistogram jobWaitHist_[SchedulingQueue::kJobTypes];  /**< waitHist_ by job type */
+    size_t lateStarts_[SchedulingQueue::kJobTypes]{};  /**< started after their edf deadline */
+    MetricsSeries metrics_;
 
     std::ostream* logStream_{nullptr};
-    std::ofstream logFile_;
+    LogSink log_;
     bool useColor_{true};
 
     void distributeRequests();
+    void routeRequests();
+    void startRequest(size_t sid, RequestHandle h);
+    size_t queuedCount() const { return rQ_.size() + serverQueued_; }
+    const IPBlocker& blocker() const { return sharedBlocker_ ? *sharedBlocker_ : ipBlocker_; }
     void scaleIfNeeded();
-    void maybeGenerateNewRequests(std::mt19937& rng);
+    void planCapacity();
+    void provisionServer(int warmup, int cls);
+    int scaleUpClass() const;
+    long long capacityOf(const WebServer& s) const;
+    void activateServer(size_t sid);
+    void retireServer(size_t sid);
+    void setIdle(size_t sid, bool idle);
+    void activateWarmedUp();
+    int planPeriod() const { return std::max(cfg_.scaleCooldown, 1); }
+    void generateArrivals(int count, bool logDrops);
+    void admit(const Request& r, bool logDrops);
+    void shed(const Request& r, ShedReason why, int now, bool logDrops);
+    void expireWaiting(int now, bool logDrops);
+    bool peekOldestWaiting(RequestHandle& h) const;
+    void dropOldestWaiting(ShedReason why, int now, bool logDrops);
+    void pruneRouted();
+    int nextArrival(int from);
+    int arrive();
+    void replayArrivals(int cycle, bool logDrops);
+    int nextTraceArrival();
+    void runCycleLoop();
+    void runEventLoop();
+    void sampleThrough(int cycle);
+    void writeHeader(unsigned int seed);
     void writeSummary();
     void writeSummaryToImpl(std::ostream& os, const std::string& namePrefix) const;
     void logEvent(const std::string& kind, const std::string& msg);
     int activeServerCount() const;
-    int nextFreeServerId() const;
+    /** Active plus warming servers: the capacity the scalers size */
+    int provisionedCount() const { return activeCount_ + static_cast<int>(warming_.size()); }
 };
 
 #endif /* LOADBALANCER_H */
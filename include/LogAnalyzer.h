@@ -0,0 +1,88 @@
+/**
+ * @file LogAnalyzer.h
+ * @brief Post-run analysis of run logs: per-server counts, scale timeline, queue percentiles
+ * @author Bizaco Load Balancer Project
+ */
+
+#ifndef LOGANALYZER_H
+#define LOGANALYZER_H
+
+#include "LogFormat.h"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @struct LogStats
+ * @brief Totals gathered from the event lines of one run log
+ *
+ * Built per chunk and merged in file order, so every member is a sum, a histogram
+ * or an ordered list.
+ */
+struct LogStats {
+    struct Server {
+        uint64_t assigned{0};
+        uint64_t completed{0};
+        uint64_t busy{0};  /**< sum of svc over reqs assigned to it */
+    };
+    struct ScaleEvent {
+        int32_t cycle;
+        bool up;
+        int32_t servers;  /**< server count after the event */
+        int64_t queue;
+    };
+
+    uint64_t bytes{0};
+    uint64_t lines{0};
+    uint64_t events{0};
+    uint64_t malformed{0};  /**< lines that look like events but do not parse */
+    int32_t firstCycle{-1};
+    int32_t lastCycle{-1};
+    std::vector<Server> servers;  /**< index = server id */
+    std::vector<ScaleEvent> scaleEvents;
+    std::vector<uint64_t> queueDepths;  /**< samples per depth, taken at COMPLETE / SCALE lines */
+    uint64_t blocked{0};
+    uint64_t shed{0};
+
+    /** Count one event record */
+    void add(const LogRecord& r);
+
+    /** Append the stats of the part of the log that follows this one */
+    void merge(const LogStats& later);
+
+    /** Queue depth at or below which a fraction q of the samples fall (-1 if none) */
+    int64_t queuePercentile(double q) const;
+};
+
+/**
+ * @class LogAnalyzer
+ * @brief Reads text or binary run logs and gathers LogStats
+ *
+ * A text log is memory-mapped and split at line boundaries into one chunk per thread;
+ * the chunks are parsed in parallel and their stats merged in order. A binary log
+ * (--log-format=binary) is delta-coded, so it is decoded on one thread.
+ */
+class LogAnalyzer {
+public:
+    /** @param threads parser threads (0 = every core) */
+    explicit LogAnalyzer(int threads = 0);
+
+    /**
+     * Analyze one log file
+     * @return false if the file cannot be read or a binary log is corrupt
+     */
+    bool analyzeFile(const std::string& path, LogStats& out);
+
+    /** Write a readable report for one file; with timeline every scale event is listed */
+    static void writeReport(const std::string& name, const LogStats& stats, double seconds,
+                            bool timeline, std::ostream& os);
+
+private:
+    int threads_;
+
+    void analyzeText(const char* data, size_t size, LogStats& out);
+    bool analyzeBinary(const char* data, size_t size, LogStats& out);
+};
+
+#endif /* LOGANALYZER_H */
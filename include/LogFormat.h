@@ -0,0 +1,96 @@
+/**
+ * @file LogFormat.h
+ * @brief Run-log event records and their text and binary encodings
+ * @author Bizaco Load Balancer Project
+ */
+
+#ifndef LOGFORMAT_H
+#define LOGFORMAT_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+/** Event record type; also the unit of log-level filtering */
+enum class LogKind : uint8_t { Text, Assign, Complete, ScaleUp, ScaleDown, Blocked, Config, Shed };
+
+/** One run-log event, as produced by the sim */
+struct LogRecord {
+    int32_t cycle;
+    LogKind kind;
+    char job;
+    int32_t a;   /**< server / new server count / shed reason */
+    int32_t b;   /**< req id */
+    int64_t c;   /**< service time / queue size / ip / cycles waited */
+};
+
+/**
+ * Append the text log line of an event record (not Text / Config), newline included
+ */
+void formatLogLine(const LogRecord& r, std::string& out);
+
+/** First bytes of a binary log */
+constexpr char kBinaryLogMagic[4] = {'B', 'Z', 'L', 'G'};
+constexpr uint8_t kBinaryLogVersion = 2;     /**< written; 2 added Shed records */
+constexpr uint8_t kBinaryLogMinVersion = 1;  /**< oldest version the decoder reads */
+
+/**
+ * @class BinaryLogEncoder
+ * @brief Packs records into a byte stream
+ *
+ * Each record is a tag byte (kind, a same-cycle bit and the job type) followed by varints;
+ * the cycle, req ids and queue depth are stored as deltas from the previous record, so
+ * a typical event takes 4-6 bytes against ~50 for its text line.
+ */
+class BinaryLogEncoder {
+public:
+    /** Append the file header (magic and version) */
+    void begin(std::string& out);
+
+    /**
+     * Append one record
+     * @param text payload of Text / Config records (ignored otherwise)
+     */
+    void encode(const LogRecord& r, const std::string* text, std::string& out);
+
+private:
+    int32_t cycle_{0};
+    int32_t assignId_{0};
+    int32_t completeId_{0};
+    int64_t queue_{0};
+};
+
+/**
+ * @class BinaryLogDecoder
+ * @brief Reads records back from a byte stream written by BinaryLogEncoder
+ */
+class BinaryLogDecoder {
+public:
+    /**
+     * Check the file header
+     * @param p in: start of the data; out: first record
+     * @return false if this is not a binary log, or one of a version outside
+     *         [kBinaryLogMinVersion, kBinaryLogVersion] (version() tells which)
+     */
+    bool begin(const char*& p, const char* end);
+
+    /** Format version from the header begin() read; 0 if it found no binary log header */
+    uint8_t version() const { return version_; }
+
+    /**
+     * Decode the next record
+     * @param p in: current position; out: next record
+     * @param text receives the payload of Text / Config records
+     * @return false at the end of the data or on a truncated / corrupt record
+     */
+    bool next(const char*& p, const char* end, LogRecord& r, std::string& text);
+
+private:
+    uint8_t version_{0};
+    int32_t cycle_{0};
+    int32_t assignId_{0};
+    int32_t completeId_{0};
+    int64_t queue_{0};
+};
+
+#endif /* LOGFORMAT_H */
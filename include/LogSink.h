@@ -0,0 +1,114 @@
+/**
+ * @file LogSink.h
+ * @brief Asynchronous run-log writer: fixed-size event records, encoded on a background thread
+ * @author Bizaco Load Balancer Project
+ */
+
+#ifndef LOGSINK_H
+#define LOGSINK_H
+
+#include "LogFormat.h"
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/** What goes into the run log */
+enum class LogLevel {
+    All,      /**< header, every event, summary */
+    Scale,    /**< header, SCALE_UP / SCALE_DOWN, summary */
+    Summary,  /**< header and summary */
+    None      /**< no log file */
+};
+
+/** How the run log is stored */
+enum class LogEncoding {
+    Text,    /**< one line per event */
+    Binary   /**< packed records (BinaryLogEncoder); lbdecode turns them back into text */
+};
+
+/**
+ * Parse "all", "scale", "summary" or "none"
+ * @return false if the name is unknown (level unchanged)
+ */
+bool parseLogLevel(const std::string& name, LogLevel& level);
+
+/**
+ * Parse "text" or "binary"
+ * @return false if the name is unknown (encoding unchanged)
+ */
+bool parseLogEncoding(const std::string& name, LogEncoding& encoding);
+
+/**
+ * @class LogSink
+ * @brief Run log fed by one simulation thread
+ *
+ * Events are pushed as 24-byte records into a lock-free single-producer ring; a writer
+ * thread turns them into text lines or packed binary records and writes them in large
+ * blocks. Free-form text (header, summary) is queued in order with the records.
+ */
+class LogSink {
+public:
+    LogSink() = default;
+    ~LogSink();
+
+    LogSink(const LogSink&) = delete;
+    LogSink& operator=(const LogSink&) = delete;
+
+    /**
+     * Create the file and start the writer thread (nothing is opened for LogLevel::None)
+     * @return true if the file is open
+     */
+    bool open(const std::string& path, LogLevel level, LogEncoding encoding = LogEncoding::Text);
+
+    /** Whether the file is open */
+    bool isOpen() const { return file_ != nullptr; }
+
+    /** Whether records of this kind are written (false while closed) */
+    bool wants(LogKind k) const { return (mask_ >> static_cast<unsigned>(k)) & 1u; }
+
+    void assign(int cycle, int server, int reqId, int serviceTime, char jobType);
+    void complete(int cycle, int server, int reqId, size_t queueSize);
+    void scaleUp(int cycle, int servers, size_t queueSize);
+    void scaleDown(int cycle, int servers, size_t queueSize);
+    void blocked(int cycle, uint32_t ip);
+    /** @param reason a ShedReason */
+    void shed(int cycle, int reqId, uint8_t reason, int waited);
+
+    /** Queue text to be written as is, after every record pushed so far */
+    void text(const std::string& s);
+
+    /** Queue run metadata ("key=value" lines); kept in binary logs only, never printed */
+    void config(const std::string& s);
+
+    /** Write everything still queued, stop the writer and close the file */
+    void close();
+
+private:
+    static constexpr size_t kRingSize = 1 << 16;  /**< records; power of two */
+
+    std::FILE* file_{nullptr};
+    unsigned mask_{0};  /**< bit per LogKind that is written */
+    LogEncoding encoding_{LogEncoding::Text};
+    BinaryLogEncoder encoder_;
+    std::unique_ptr<LogRecord[]> ring_;
+    alignas(64) std::atomic<size_t> head_{0};  /**< next record to encode; writer thread */
+    alignas(64) std::atomic<size_t> tail_{0};  /**< next free slot; sim thread */
+    size_t cachedHead_{0};
+    std::atomic<bool> stop_{false};
+    std::mutex textMutex_;
+    std::deque<std::string> texts_;  /**< payloads of Text / Config records, in order */
+    std::thread writer_;
+
+    void push(const LogRecord& r);
+    void queueText(LogKind kind, const std::string& s);
+    void writerLoop();
+    void encode(const LogRecord& r, std::string& out);
+};
+
+#endif /* LOGSINK_H */
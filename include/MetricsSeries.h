@@ -0,0 +1,71 @@
+/**
+ * @file MetricsSeries.h
+ * @brief Time series of LB state sampled every K cycles, written as CSV or Prometheus text
+ * @author Bizaco Load Balancer Project
+ */
+
+#ifndef METRICSSERIES_H
+#define METRICSSERIES_H
+
+#include <climits>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/** File format of a metrics export */
+enum class MetricsFormat {
+    Csv,        /**< one row per sample and series */
+    Prometheus  /**< text exposition format; the timestamp field holds the cycle */
+};
+
+/**
+ * Parse "csv" or "prom"
+ * @return false if the name is unknown (format unchanged)
+ */
+bool parseMetricsFormat(const std::string& name, MetricsFormat& format);
+
+/**
+ * @class MetricsSeries
+ * @brief Columnar buffer of samples taken at the end of cycles K-1, 2K-1, ...
+ *
+ * Every column is reserved up front for the whole run, so recording a sample never
+ * allocates. Gauges (queue, active servers, in-flight reqs) are the values at the
+ * sample; counters (arrivals, completions, blocked) are totals since the run began.
+ */
+class MetricsSeries {
+public:
+    /** Sample every interval cycles over runTime cycles; interval <= 0 turns sampling off */
+    void reset(int interval, int runTime);
+
+    bool enabled() const { return interval_ > 0; }
+    /** Cycle whose end state the next sample records (INT_MAX when off) */
+    int nextSample() const { return next_; }
+    size_t size() const { return cycle_.size(); }
+
+    /** Record the state at the end of cycle nextSample() and move on to the next one */
+    void record(int64_t queue, int active, int inFlight, uint64_t arrivals, uint64_t completions, uint64_t blocked);
+
+    /** Add another series sampled at the same cycles, column by column */
+    void accumulate(const MetricsSeries& other);
+
+    /**
+     * Write labeled series sampled at the same cycles to one file
+     * @return false if the file cannot be written
+     */
+    static bool writeFile(const std::string& path, MetricsFormat format,
+                          const std::vector<std::pair<std::string, const MetricsSeries*>>& series);
+
+private:
+    int interval_{0};
+    int next_{INT_MAX};
+    std::vector<int32_t> cycle_;
+    std::vector<int64_t> queue_;
+    std::vector<int32_t> active_;
+    std::vector<int32_t> inFlight_;
+    std::vector<uint64_t> arrivals_;
+    std::vector<uint64_t> completions_;
+    std::vector<uint64_t> blocked_;
+};
+
+#endif /* METRICSSERIES_H */
@@ -0,0 +1,77 @@
+/**
+ * @file Philox.h
+ * @brief Philox4x32-10 counter-based random numbers (Salmon et al., SC'11)
+ * @author Bizaco Load Balancer Project
+ *
+ * A block of four 32-bit words is a pure function of (key, counter), so any draw can be
+ * made on any thread in any order. Plain loops over philox4x32 vectorize.
+ */
+
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <cstdint>
+#include <limits>
+
+/** Four random words */
+struct PhiloxBlock {
+    uint32_t w[4];
+};
+
+/**
+ * Philox4x32-10 of counter (index, stream) under key
+ * @param index 64-bit position within a stream
+ * @param stream independent sequence number (e.g. one per kind of draw)
+ */
+inline PhiloxBlock philox4x32(uint64_t key, uint64_t index, uint32_t stream) {
+    uint32_t c0 = static_cast<uint32_t>(index), c1 = static_cast<uint32_t>(index >> 32), c2 = stream, c3 = 0;
+    uint32_t k0 = static_cast<uint32_t>(key), k1 = static_cast<uint32_t>(key >> 32);
+    for (int round = 0; round < 10; ++round) {
+        uint64_t p0 = uint64_t{0xD2511F53} * c0;
+        uint64_t p1 = uint64_t{0xCD9E8D57} * c2;
+        uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+        uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+        c1 = static_cast<uint32_t>(p1);
+        c3 = static_cast<uint32_t>(p0);
+        c0 = n0;
+        c2 = n2;
+        k0 += 0x9E3779B9;
+        k1 += 0xBB67AE85;
+    }
+    return {{c0, c1, c2, c3}};
+}
+
+/** Uniform in (0, 1) from 32 bits, never exactly 0 or 1 */
+inline double philoxUniform(uint32_t bits) {
+    return (static_cast<double>(bits) + 0.5) * (1.0 / 4294967296.0);
+}
+
+/**
+ * @class PhiloxStream
+ * @brief Consecutive blocks of one (key, stream) as a standard random bit generator
+ */
+class PhiloxStream {
+public:
+    using result_type = uint32_t;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<uint32_t>::max(); }
+
+    PhiloxStream(uint64_t key = 0, uint32_t stream = 0) : key_(key), stream_(stream) {}
+
+    result_type operator()() {
+        if (used_ == 4) {
+            block_ = philox4x32(key_, index_++, stream_);
+            used_ = 0;
+        }
+        return block_.w[used_++];
+    }
+
+private:
+    uint64_t key_;
+    uint32_t stream_;
+    uint64_t index_{0};
+    PhiloxBlock block_{};
+    int used_{4};
+};
+
+#endif /* PHILOX_H */
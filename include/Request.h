@@ -7,15 +7,18 @@
 #ifndef REQUEST_H
 #define REQUEST_H
 
-#include <string>
+#include <cstdint>
 
 /**
  * @struct Request
  * @brief A single web req with IPs, service time, and job type
+ *
+ * Trivially copyable and 24 bytes; IPs are packed (a.b.c.d == a<<24 | b<<16 | c<<8 | d)
+ * and only formatted when a log line needs them.
  */
 struct Request {
-    std::string ipIn;     /**< incoming IP address */
-    std::string ipOut;    /**< outgoing IP address */
+    uint32_t ipIn{0};     /**< incoming IP address */
+    uint32_t ipOut{0};    /**< outgoing IP address */
     int serviceTime{0};    /**< Clock cycles required to process */
     char jobType{'P'};    /**< 'P' = Processing, 'S' = Streaming */
     int arrivalTime{0};    /**< Clock cycle when the req was created */
@@ -23,9 +26,15 @@ struct Request {
 
     Request() = default;
 
-    Request(std::string in, std::string out, int time, char type, int arrival, int reqId = 0)
-        : ipIn(std::move(in)), ipOut(std::move(out)),
+    Request(uint32_t in, uint32_t out, int time, char type, int arrival, int reqId = 0)
+        : ipIn(in), ipOut(out),
           serviceTime(time), jobType(type), arrivalTime(arrival), id(reqId) {}
 };
 
+/** 32-bit handle of a Request held in a RequestPool */
+using RequestHandle = uint32_t;
+
+/** Handle value meaning "no request" */
+constexpr RequestHandle kNoRequest = 0xFFFFFFFFu;
+
 #endif /* REQUEST_H */
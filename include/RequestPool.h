@@ -0,0 +1,57 @@
+/**
+ * @file RequestPool.h
+ * @brief Slab arena that owns Requests and hands out 32-bit handles
+ * @author Bizaco Load Balancer Project
+ */
+
+#ifndef REQUESTPOOL_H
+#define REQUESTPOOL_H
+
+#include "Request.h"
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+/**
+ * @class RequestPool
+ * @brief Stores Requests in fixed-size slabs; released slots are recycled through a free list
+ *
+ * Slabs are never moved or freed, so once the pool has grown to the peak number of
+ * live requests, acquire/release do no heap allocation.
+ */
+class RequestPool {
+public:
+    RequestPool() = default;
+
+    /**
+     * Copy a req into a free slot
+     * @param r req to store
+     * @return handle of the stored req
+     */
+    RequestHandle acquire(const Request& r);
+
+    /**
+     * Return a slot to the free list; the handle must not be used afterwards
+     */
+    void release(RequestHandle h);
+
+    /** Req stored under a live handle */
+    Request& get(RequestHandle h) { return slabs_[h >> kSlabShift][h & kSlabMask]; }
+    const Request& get(RequestHandle h) const { return slabs_[h >> kSlabShift][h & kSlabMask]; }
+
+    /** Number of live reqs */
+    size_t size() const;
+
+    /** Number of slots allocated so far */
+    size_t capacity() const;
+
+private:
+    static constexpr uint32_t kSlabShift = 12;  /**< 4096 reqs (96KB) per slab */
+    static constexpr uint32_t kSlabMask = (1u << kSlabShift) - 1;
+
+    std::vector<std::unique_ptr<Request[]>> slabs_;
+    std::vector<RequestHandle> free_;
+    uint32_t used_{0};  /**< slots handed out at least once */
+};
+
+#endif /* REQUESTPOOL_H */
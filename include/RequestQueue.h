@@ -1,6 +1,6 @@
 /**
  * @file RequestQueue.h
- * @brief Queue of Request objects for the LB
+ * @brief Queue of Request handles for the LB
  * @author Bizaco Load Balancer Project
  */
 
@@ -8,12 +8,15 @@
 #define REQUESTQUEUE_H
 
 #include "Request.h"
-#include <queue>
+#include <vector>
 #include <cstddef>
 
 /**
  * @class RequestQueue
- * @brief Wrapper around std::queue<Request> for the LB
+ * @brief FIFO ring buffer of RequestHandles for the LB; reqs live in a RequestPool
+ *
+ * Capacity is a power of two and only grows (doubling), so once the queue has seen its
+ * peak depth, enqueue/dequeue never allocate.
  */
 class RequestQueue {
 public:
@@ -21,16 +24,36 @@ public:
 
     /**
      * Add a req to the back of the queue
-     * @param r req to enqueue
+     * @param h handle of the req to enqueue
      */
-    void enqueue(const Request& r);
+    void enqueue(RequestHandle h);
 
     /**
      * Remove and return the front req if the queue is not empty
-     * @param out req to fill with front value
+     * @param out handle to fill with front value
      * @return true if a req was dequeued, false if queue was empty
      */
-    bool try_dequeue(Request& out);
+    bool try_dequeue(RequestHandle& out);
+
+    /**
+     * Look at the front req without removing it
+     * @param out handle to fill with front value
+     * @return true if the queue was not empty
+     */
+    bool peek(RequestHandle& out) const;
+
+    /**
+     * Remove up to n reqs from the front, in order
+     * @param out array of at least n handles to fill
+     * @param n maximum number of reqs to remove
+     * @return number of reqs removed
+     */
+    size_t dequeue_batch(RequestHandle* out, size_t n);
+
+    /**
+     * Make room for at least n reqs without further allocation
+     */
+    void reserve(size_t n);
 
     /**
      * Number of reqs currently in the queue
@@ -43,7 +66,11 @@ public:
     bool empty() const;
 
 private:
-    std::queue<Request> queue_;
+    std::vector<RequestHandle> buf_;  /**< size is a power of two (or 0) */
+    size_t head_{0};                  /**< index of the front req, in [0, buf_.size()) */
+    size_t count_{0};
+
+    void grow(size_t minCapacity);
 };
 
 #endif /* REQUESTQUEUE_H */
@@ -0,0 +1,134 @@
+/**
+ * @file SchedulingQueue.h
+ * @brief The LB's central queue, ordered by a scheduling discipline (--queue-discipline)
+ * @author Bizaco Load Balancer Project
+ */
+
+#ifndef SCHEDULINGQUEUE_H
+#define SCHEDULINGQUEUE_H
+
+#include "Config.h"
+#include "Request.h"
+#include "RequestPool.h"
+#include "RequestQueue.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/** Order in which queued reqs are handed to servers */
+enum class QueueDiscipline {
+    Fifo,      /**< arrival order (the original queue) */
+    Priority,  /**< strict priority: every queued req of cfg.priorityJobType first, FIFO within a job type */
+    Sjf,       /**< shortest service time first, FIFO among equals */
+    Edf,       /**< earliest deadline first: arrival + the job type's deadline */
+    Wfq        /**< weighted fair queueing between job types (self-clocked finish tags) */
+};
+
+/** @return false if s names no discipline (d unchanged) */
+bool parseQueueDiscipline(const std::string& s, QueueDiscipline& d);
+
+/**
+ * @class SchedulingQueue
+ * @brief Queue of RequestHandles with the RequestQueue interface, dequeued in discipline order
+ *
+ * FIFO is the RequestQueue ring. The other disciplines link queued reqs through arrays
+ * indexed by handle: one list per job type (priority, edf and wfq pick between the list
+ * heads, O(1)) or an indexed binary heap on service time (sjf, O(log n)), plus a list in
+ * arrival order so the longest-waiting req can be found and removed in O(1) whatever the
+ * order. Once the arrays have grown to the pool's peak size nothing allocates.
+ */
+class SchedulingQueue {
+public:
+    static constexpr size_t kStreaming = 0;  /**< job type index of 'S' */
+    static constexpr size_t kProcessing = 1; /**< job type index of 'P' (and anything else) */
+    static constexpr size_t kJobTypes = 2;
+
+    /** Unknown names in cfg fall back to FIFO (main validates them); reqs are read from pool */
+    SchedulingQueue(const Config& cfg, const RequestPool& pool);
+
+    /** Add a queued req */
+    void enqueue(RequestHandle h);
+
+    /**
+     * Remove and return the req the discipline serves next
+     * @return false if the queue was empty
+     */
+    bool try_dequeue(RequestHandle& out);
+
+    /** Req the discipline serves next, without removing it */
+    bool peek(RequestHandle& out) const;
+
+    /**
+     * Remove up to n reqs in service order
+     * @return number of reqs removed
+     */
+    size_t dequeue_batch(RequestHandle* out, size_t n);
+
+    /** Longest-waiting req (timeouts, drop-oldest) */
+    bool peekOldest(RequestHandle& out) const;
+    /** Remove the longest-waiting req */
+    bool removeOldest(RequestHandle& out);
+
+    /** Make room for at least n reqs (and handles below n) without further allocation */
+    void reserve(size_t n);
+
+    size_t size() const { return discipline_ == QueueDiscipline::Fifo ? fifo_.size() : count_; }
+    bool empty() const { return size() == 0; }
+
+    QueueDiscipline discipline() const { return discipline_; }
+    /** Cycles a req of job type index t may wait before missing its deadline (edf) */
+    int deadline(size_t t) const { return deadline_[t]; }
+    /** One line for run log headers, e.g. "edf (deadline S 50, P 500 cycles)" */
+    std::string describe() const;
+
+    static size_t jobTypeIndex(char jobType) { return jobType == 'S' ? kStreaming : kProcessing; }
+
+private:
+    /** Links of a queued req; kNoRequest ends a list */
+    struct Node {
+        RequestHandle agePrev;
+        RequestHandle ageNext;
+        RequestHandle prev;  /**< within its job type's list */
+        RequestHandle next;
+    };
+    struct List {
+        RequestHandle head{kNoRequest};
+        RequestHandle tail{kNoRequest};
+    };
+    /** sjf heap entry: ordered by (key, id) */
+    struct HeapEntry {
+        int64_t key;
+        int id;
+        RequestHandle h;
+    };
+
+    QueueDiscipline discipline_{QueueDiscipline::Fifo};
+    const RequestPool& pool_;
+    RequestQueue fifo_;
+    size_t count_{0};
+    size_t first_;                /**< priority: job type index served first */
+    int deadline_[kJobTypes];
+    double cost_[kJobTypes];      /**< wfq: finish-tag increase per unit of service time (1 / weight) */
+    double lastTag_[kJobTypes]{};
+    double vtime_{0};             /**< wfq: tag of the req last served */
+    std::vector<Node> node_;      /**< by handle */
+    std::vector<double> tag_;     /**< wfq: finish tag, by handle */
+    std::vector<uint32_t> heapPos_;  /**< sjf: index in heap_, by handle */
+    std::vector<HeapEntry> heap_;
+    List age_;
+    List lanes_[kJobTypes];
+
+    void grow(size_t handles);
+    long pickLane() const;
+    void remove(RequestHandle h);
+    void pushLane(List& l, RequestHandle h);
+    void unlinkLane(List& l, RequestHandle h);
+    static bool before(const HeapEntry& a, const HeapEntry& b) { return a.key < b.key || (a.key == b.key && a.id < b.id); }
+    void place(size_t i, const HeapEntry& e);
+    void siftUp(size_t i);
+    void siftDown(size_t i);
+    void heapErase(size_t i);
+};
+
+#endif /* SCHEDULINGQUEUE_H */
@@ -0,0 +1,50 @@
+/**
+ * @file ServerSet.h
+ * @brief Set of server indices with fast lowest / highest member lookup
+ * @author Bizaco Load Balancer Project
+ */
+
+#ifndef SERVERSET_H
+#define SERVERSET_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @class ServerSet
+ * @brief Two-level bitset: one bit per server plus one summary bit per 64-server word
+ *
+ * insert/erase are O(1); first/last skip empty words 64 at a time through the summary,
+ * so finding a member among 100k servers touches a few dozen words at most.
+ */
+class ServerSet {
+public:
+    ServerSet() = default;
+
+    /** Make room for indices [0, n) */
+    void resize(size_t n);
+
+    void insert(size_t i);
+    void erase(size_t i);
+    bool contains(size_t i) const;
+
+    /** Lowest member, or -1 if empty */
+    long first() const;
+
+    /** Highest member, or -1 if empty */
+    long last() const;
+
+    /** Lowest member >= i, or -1 if there is none */
+    long next(size_t i) const;
+
+    bool empty() const { return count_ == 0; }
+    size_t size() const { return count_; }
+
+private:
+    std::vector<uint64_t> words_;
+    std::vector<uint64_t> summary_;  /**< bit w set iff words_[w] != 0 */
+    size_t count_{0};
+};
+
+#endif /* SERVERSET_H */
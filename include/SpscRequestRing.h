@@ -0,0 +1,56 @@
+/**
+ * @file SpscRequestRing.h
+ * @brief Single-producer / single-consumer ring of Requests between threads
+ * @author Bizaco Load Balancer Project
+ */
+
+#ifndef SPSCREQUESTRING_H
+#define SPSCREQUESTRING_H
+
+#include "Request.h"
+#include <atomic>
+#include <memory>
+#include <cstddef>
+
+/**
+ * @class SpscRequestRing
+ * @brief Bounded lock-free ring with exactly one pushing and one popping thread
+ *
+ * Each side owns its index and keeps a cached copy of the other side's, so the shared
+ * cache line is only read again when the ring looks full (producer) or empty (consumer).
+ */
+class SpscRequestRing {
+public:
+    /**
+     * @param capacity Minimum number of reqs the ring can hold (rounded up to a power of two)
+     */
+    explicit SpscRequestRing(size_t capacity);
+
+    SpscRequestRing(const SpscRequestRing&) = delete;
+    SpscRequestRing& operator=(const SpscRequestRing&) = delete;
+
+    /**
+     * Producer: append a req
+     * @return false if the ring is full
+     */
+    bool try_push(const Request& r);
+
+    /**
+     * Consumer: front req without removing it
+     * @return nullptr if the ring is empty
+     */
+    const Request* peek();
+
+    /** Consumer: remove the front req (only after peek returned non-null) */
+    void pop();
+
+private:
+    std::unique_ptr<Request[]> buf_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> head_{0};  /**< next slot to pop; written by the consumer */
+    size_t cachedTail_{0};                     /**< consumer's view of tail_ */
+    alignas(64) std::atomic<size_t> tail_{0};  /**< next slot to fill; written by the producer */
+    size_t cachedHead_{0};                     /**< producer's view of head_ */
+};
+
+#endif /* SPSCREQUESTRING_H */
@@ -0,0 +1,77 @@
+/**
+ * @file Sweep.h
+ * @brief Parameter sweep: runs a grid of configs x N seeds on a thread pool
+ * @author Bizaco Load Balancer Project
+ */
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "Config.h"
+#include "IPBlocker.h"
+#include <string>
+#include <vector>
+#include <ostream>
+
+/**
+ * @class Sweep
+ * @brief Expands a parameter grid x N seeds, runs every LB sim with logging off on a pool
+ *        of threads, and writes one CSV row per grid point (mean and p95 across seeds).
+ *
+ * Sweep file: config.cfg keys. A value listing several values ("5,10,20") or a range
+ * ("30:60:10", inclusive, step defaults to 1) makes that key a grid axis; anything else
+ * is applied to every run. Extra keys: seeds (runs per grid point, default 10) and
+ * seedBase (first seed, default 1).
+ */
+class Sweep {
+public:
+    /**
+     * @param base Config every run starts from (config.cfg plus command line)
+     */
+    explicit Sweep(const Config& base);
+
+    /**
+     * Read the sweep file
+     * @param path Path to sweep file
+     * @return false if the file cannot be read
+     */
+    bool loadFromFile(const std::string& path);
+
+    /** Config shared by all runs once the sweep file is loaded (for blocker setup) */
+    const Config& getBaseConfig() const { return base_; }
+
+    /** Firewall shared (read-only) by every run */
+    IPBlocker& getIPBlocker() { return ipBlocker_; }
+
+    /** Number of grid points */
+    size_t pointCount() const;
+
+    /** Number of sims (grid points x seeds) */
+    size_t runCount() const;
+
+    /**
+     * Run every sim and write the CSV
+     * @param threads Pool size; 0 = one per core
+     * @param csvPath Output file
+     * @param progress Optional stream for start / end messages
+     * @return false if the CSV cannot be written
+     */
+    bool run(int threads, const std::string& csvPath, std::ostream* progress);
+
+private:
+    /** One grid dimension: a config key and the values it takes */
+    struct Axis {
+        std::string key;
+        std::vector<std::string> values;
+    };
+
+    Config base_;
+    IPBlocker ipBlocker_;
+    std::vector<Axis> axes_;
+    int seeds_{10};
+    unsigned int seedBase_{1};
+
+    Config pointConfig(size_t point) const;
+};
+
+#endif /* SWEEP_H */
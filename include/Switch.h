@@ -13,15 +13,25 @@
 #include "LoadBalancer.h"
 #include "Request.h"
 #include "IPBlocker.h"
+#include "SpscRequestRing.h"
+#include "MetricsSeries.h"
+#include "Workload.h"
+#include <atomic>
 #include <memory>
 #include <ostream>
 #include <fstream>
 #include <random>
+#include <vector>
 
 /**
  * @class Switch
  * @brief Routes jobs by type: 'S' (Streaming) to one LB, 'P' (Processing) to another.
- *        Runs both LBs in lockstep for the same runTime, writing combined and per-LB stats.
+ *        Runs both LBs for the same runTime, writing combined and per-LB stats.
+ *
+ * With cfg.parallelSwitch each LB runs on its own thread (a lane). The switch thread pushes
+ * routed reqs into one SPSC ring per lane and, once per epoch, publishes a watermark: the
+ * cycle before which every arrival has been pushed. A lane runs cycle t only once the
+ * watermark is past t, so each LB sees exactly the arrivals the serial loop would give it.
  */
 class Switch {
 public:
@@ -30,27 +40,58 @@ public:
     void setLogStream(std::ostream* os);
     void setLogFile(const std::string& path);
 
+    /**
+     * Route reqs from a trace instead of generating them (see LoadBalancer::openTrace)
+     * @return false if it cannot be opened (getTrace()->error() says why)
+     */
+    bool openTrace(const std::string& path);
+    /** The trace being replayed, or nullptr; check error() after the run */
+    const TraceReader* getTrace() const { return trace_.get(); }
+
     /** Access IP blocker for routing (blocked reqs are not sent to either LB) */
     IPBlocker& getIPBlocker() { return ipBlocker_; }
 
     /**
      * Run sim: generate reqs, route by type, advance both LBs each cycle
+     * (or only at event cycles with engine=event)
      */
     void runSimulation();
 
+    /**
+     * Write the sampled series (cfg.metricsInterval, cfg.metricsFormat): one per LB plus
+     * "switch", their sum with the reqs blocked at the switch
+     * @return false if the file cannot be written
+     */
+    bool writeMetrics(const std::string& path) const;
+
 private:
     Config cfg_;
     LoadBalancer lbStreaming_;
     LoadBalancer lbProcessing_;
     IPBlocker ipBlocker_;
+    Workload workload_;
+    Workload::Batch batch_;          /**< scratch: fields of reqs being generated */
+    std::vector<Request> arrivals_;  /**< scratch: reqs arriving this cycle, not blocked */
+    std::unique_ptr<TraceReader> trace_;
     int nextRequestId_{1};
     size_t totalBlocked_{0};
+    MetricsSeries metrics_;  /**< blocked-at-switch samples; writeMetrics adds the LBs' */
 
     std::ostream* logStream_{nullptr};
     std::ofstream logFile_;
 
-    void generateAndRouteInitialQueue(std::mt19937& rng);
-    void generateAndRouteOneCycle(std::mt19937& rng, int currentTime);
+    void generateAndRouteInitialQueue();
+    void drawArrivals(int count, int currentTime, std::vector<Request>& out);
+    void takeTraceArrivals(int cycle, size_t limit, std::vector<Request>& out);
+    int nextArrival(int from);
+    void takeArrivals(int currentTime);
+    void route(const Request& r);
+    void runSerial();
+    void runParallel();
+    void runLane(LoadBalancer& lb, SpscRequestRing& ring);
+    void sampleThrough(int cycle);
+
+    std::atomic<int> watermark_{0};  /**< parallel mode: all arrivals before this cycle are pushed */
 };
 
 #endif /* SWITCH_H */
@@ -0,0 +1,111 @@
+/**
+ * @file Trace.h
+ * @brief Recorded request traces (JSONL or compact binary), read as a stream for replay
+ * @author Bizaco Load Balancer Project
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/** One recorded req */
+struct TraceRecord {
+    int32_t arrival{0};      /**< cycle it arrives at (non-decreasing through a trace) */
+    uint32_t ipIn{0};
+    uint32_t ipOut{0};
+    int32_t serviceTime{1};  /**< at least 1 */
+    char jobType{'P'};       /**< 'S' or 'P' */
+};
+
+/** First bytes of a binary trace */
+constexpr char kTraceMagic[4] = {'B', 'Z', 'T', 'R'};
+constexpr uint8_t kTraceVersion = 1;
+
+/**
+ * Append a record as one JSONL line, newline included:
+ * {"arrival":12,"ipIn":"10.0.0.1","ipOut":"192.168.1.9","serviceTime":17,"jobType":"S"}
+ */
+void formatTraceJson(const TraceRecord& r, std::string& out);
+
+/**
+ * @class TraceReader
+ * @brief Streams a trace through a fixed-size buffer, one record at a time
+ *
+ * The format is detected from the first bytes: binary traces start with kTraceMagic,
+ * anything else is read as JSONL (one object per line; ipIn / ipOut as dotted strings
+ * or integers, "arrivalTime" accepted for "arrival", blank lines skipped). Memory use
+ * does not depend on the trace length. A malformed or out-of-order record ends the
+ * stream with error() set.
+ */
+class TraceReader {
+public:
+    /**
+     * Open a trace and read its header
+     * @return false if the file cannot be read (error() says why)
+     */
+    bool open(const std::string& path);
+
+    /** Next record, or nullptr at the end of the trace or after an error */
+    const TraceRecord* peek() {
+        if (!have_ && !done_) advance();
+        return have_ ? &cur_ : nullptr;
+    }
+    /** Drop the record peek() returned */
+    void pop() { have_ = false; }
+
+    bool binary() const { return binary_; }
+    /** Records read so far */
+    size_t count() const { return count_; }
+    /** Empty unless the trace was malformed; names the line (JSONL) or record (binary) */
+    const std::string& error() const { return error_; }
+
+private:
+    std::ifstream in_;
+    std::vector<char> buf_;
+    size_t pos_{0};
+    size_t end_{0};
+    bool eof_{false};
+    bool binary_{false};
+    bool have_{false};
+    bool done_{false};
+    TraceRecord cur_;
+    int32_t lastArrival_{0};
+    size_t count_{0};
+    size_t line_{0};
+    std::string error_;
+
+    void advance();
+    bool fill();
+    bool parseJson(const char* p, const char* end);
+    void fail(const std::string& what);
+};
+
+/**
+ * @class TraceWriter
+ * @brief Writes records as a binary trace
+ *
+ * Each record is a varint arrival delta, ipIn and ipOut as 4 little-endian bytes each,
+ * and a varint of serviceTime * 2 + (jobType == 'S'): 11-12 bytes for a typical record
+ * against ~90 for its JSONL line.
+ */
+class TraceWriter {
+public:
+    /** @return false if the file cannot be created */
+    bool open(const std::string& path);
+    /** Append a record (arrivals must not decrease) */
+    void write(const TraceRecord& r);
+    /** Flush and close; @return false if anything failed to write */
+    bool close();
+
+private:
+    std::ofstream out_;
+    std::string buf_;
+    int32_t lastArrival_{0};
+};
+
+#endif /* TRACE_H */
@@ -1,6 +1,6 @@
 /**
  * @file WebServer.h
- * @brief Single web server that processes one request at a time
+ * @brief Web server with one or more req slots running at a speed factor
  * @author Bizaco Load Balancer Project
  */
 
@@ -8,27 +8,76 @@
 #define WEBSERVER_H
 
 #include "Request.h"
+#include <string>
+#include <vector>
+
+/** A kind of server in a mixed fleet (config key serverClass=name:count:slots:speed) */
+struct ServerClass {
+    std::string name{"default"};
+    int count{0};       /**< servers of this class in the initial fleet; also its share of scale-ups */
+    int slots{1};       /**< reqs it runs at once */
+    double speed{1.0};  /**< service time is divided by this */
+};
+
+/**
+ * Parse "name:count:slots:speed" (slots and speed optional, default 1)
+ * @return false if malformed (cls unchanged)
+ */
+bool parseServerClass(const std::string& spec, ServerClass& cls);
 
 /**
  * @class WebServer
- * @brief Handles one request at a time; tracks state until completion
+ * @brief Runs up to slots() reqs at once, each for its service time / speed()
+ *
+ * Counts the slot-cycles it spends busy, idle (active, slot free), warming up and
+ * inactive (before it was added or after it was scaled down); a server with k slots
+ * counts k per cycle. Counts are settled at each state change, so skipped idle cycles
+ * (event engine) cost nothing. Free slots are kept on a stack: assigning and completing
+ * a req cost the same however many slots there are.
  */
 class WebServer {
 public:
+    /** Lifecycle of a server slot */
+    enum class State {
+        Inactive,  /**< free slot: not provisioned */
+        WarmingUp, /**< provisioned, not taking reqs yet */
+        Active,    /**< taking reqs */
+        Draining   /**< scaled down while busy: finishes its work, takes no new reqs */
+    };
+
+    /** Slot-cycles spent in each state */
+    struct CycleCounts {
+        long long busy{0};
+        long long idle{0};
+        long long warming{0};
+        long long inactive{0};
+    };
+
     /**
      * @param id unique server identifier
+     * @param startTime cycle it is added at (earlier cycles count as inactive)
+     * @param slots reqs it runs at once (at least 1)
+     * @param speed service time divisor (> 0)
+     * @param cls index of its ServerClass
      */
-    explicit WebServer(int id);
+    explicit WebServer(int id, int startTime = 0, int slots = 1, double speed = 1.0, int cls = 0);
 
     /**
      * if server is still processing a req at the given time
      */
     bool isBusy(int currentTime) const;
 
+    /** Cycles a req takes on this server: its service time / speed, at least 1 */
+    int serviceCycles(const Request& r) const;
+
     /**
-     * assign a req to the server
+     * assign a req to a free slot (hasFreeSlot() must be true)
+     * @param h handle of the req (owned by the LB's RequestPool)
+     * @param r the req itself, for its service time
+     * @param currentTime cycle the req starts
+     * @return slot the req runs in
      */
-    void assignRequest(const Request& r, int currentTime);
+    int assignRequest(RequestHandle h, const Request& r, int currentTime);
 
     /**
      * adv. server state
@@ -36,28 +85,61 @@ public:
     void tick(int currentTime);
 
     int getId() const;
+    int slots() const { return static_cast<int>(slot_.size()); }
+    double speed() const { return speed_; }
+    int serverClass() const { return cls_; }
+    bool hasFreeSlot() const { return !free_.empty(); }
+    int freeSlots() const { return static_cast<int>(free_.size()); }
+    int busySlots() const { return slots() - freeSlots(); }
+
+    /**
+     * cycle at which the given slot's req finishes (-1 if the slot is free)
+     */
+    int busyUntil(int slot) const { return slot_[static_cast<size_t>(slot)].until; }
+    /** earliest finish over the running reqs (-1 if none) */
+    int busyUntil() const;
 
     /**
      * if server is not deallocated
      */
     bool active() const;
-    void setActive(bool a);
+    State state() const { return state_; }
+    /** Move to another lifecycle state at the given cycle */
+    void setState(State s, int currentTime);
 
     /**
-     * Req currently being procesed
+     * Slot-cycles spent in each state from cycle 0 up to (not including) now
      */
-    const Request* currentRequest() const;
+    CycleCounts cycleCounts(int now) const;
 
     /**
-     * Set current request as completed; cna accept new work
+     * Handle of the req in the given slot, or kNoRequest
      */
-    void markCompleted();
+    RequestHandle currentRequest(int slot) const;
+
+    /**
+     * Set the req in the given slot as completed; the slot cna accept new work
+     */
+    void markCompleted(int slot);
 
 private:
+    struct Slot {
+        int until{-1};
+        int start{0};
+        RequestHandle req{kNoRequest};
+    };
+
     int id_;
-    int bU_{-1};
-    bool active_{true};
-    Request cR_;
+    double speed_;
+    int cls_;
+    State state_{State::Active};
+    std::vector<Slot> slot_;
+    std::vector<int> free_;  /**< free slot indices; the last one freed is reused first */
+    int since_{0};           /**< cycle the current state began */
+    long long inactive_{0};  /**< settled server-cycles per state, up to since_ */
+    long long warming_{0};
+    long long up_{0};        /**< active or draining */
+    long long busyDone_{0};  /**< slot-cycles of completed reqs */
 };
 
 #endif /* WEBSERVER_H */
@@ -0,0 +1,124 @@
+/**
+ * @file Workload.h
+ * @brief Generated reqs: arrival process and service-time distribution (config.cfg)
+ * @author Bizaco Load Balancer Project
+ */
+
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include "Config.h"
+#include "IPBlocker.h"
+#include "Philox.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/** How many reqs arrive in each cycle */
+enum class ArrivalProcess {
+    Bernoulli, /**< at most 1, with newRequestProbabilityPercent (the original generator) */
+    Poisson,   /**< Poisson(arrivalRate) */
+    Mmpp,      /**< Poisson, rate switching between arrivalRate (calm) and burstRate spells */
+    Diurnal    /**< Poisson, rate arrivalRate x (1 + amplitude x sin(2 pi t / diurnalPeriod)) */
+};
+
+/** Service time of each generated req, clamped to [minServiceTime, maxServiceTime] */
+enum class ServiceDistribution { Uniform, Exponential, Lognormal, Pareto };
+
+/** @return false if s names no arrival process (p unchanged) */
+bool parseArrivalProcess(const std::string& s, ArrivalProcess& p);
+/** @return false if s names no service distribution (d unchanged) */
+bool parseServiceDistribution(const std::string& s, ServiceDistribution& d);
+
+/**
+ * @class Workload
+ * @brief Draws arrival cycles and the reqs arriving in them
+ *
+ * Every draw is counter-based (Philox keyed by the seed): the fields of req id i depend
+ * only on (seed, i), so batches can be drawn on any number of threads with the same
+ * result, and arrival draws come from a stream of their own. nextArrival jumps straight
+ * to the next cycle with any arrivals (one geometric draw per gap, exact for Bernoulli
+ * and per-cycle Poisson counts), so the cycle and event engines see the same arrivals.
+ */
+class Workload {
+public:
+    /** Fields of a batch of reqs, index i for the i-th */
+    struct Batch {
+        std::vector<uint32_t> ipIn;
+        std::vector<uint32_t> ipOut;
+        std::vector<int> serviceTime;
+        std::vector<char> jobType;
+        std::vector<uint64_t> blocked;  /**< generate(): bit i set if req i is blocked */
+        std::vector<uint32_t> bits;     /**< scratch: random words behind serviceTime */
+        size_t size() const { return serviceTime.size(); }
+        bool isBlocked(size_t i) const { return (blocked[i >> 6] >> (i & 63)) & 1; }
+    };
+    /** Receives consecutive chunks of generate() */
+    using ChunkFn = std::function<void(const Batch& chunk)>;
+
+    /** Unknown names in cfg fall back to the defaults (main validates them) */
+    explicit Workload(const Config& cfg);
+
+    /** Key every draw with seed and restart the arrival stream */
+    void seed(unsigned int seed);
+
+    /**
+     * First cycle at or after from with arrivals (cfg.runTime if none before it);
+     * arrivals() is then their count. Calls must move forward in time.
+     */
+    int nextArrival(int from);
+    /** Reqs arriving at the cycle nextArrival returned */
+    int arrivals() const { return count_; }
+
+    /** Bernoulli coin of one cycle, independent of nextArrival (real-time producers) */
+    bool arrivesAt(int cycle) const;
+
+    /** Draw reqs firstId .. firstId + n - 1 into out (resized to n); safe to call concurrently */
+    void draw(uint64_t firstId, size_t n, Batch& out) const;
+
+    /**
+     * Draw reqs firstId .. firstId + n - 1 and flag those blocker blocks, on up to
+     * cfg.generatorThreads threads for large n; take() gets the chunks in id order on the
+     * calling thread. The result does not depend on the thread count.
+     * @param scratch batch reused for the chunks drawn on the calling thread
+     */
+    void generate(uint64_t firstId, size_t n, const IPBlocker& blocker, Batch& scratch, const ChunkFn& take) const;
+
+    /** true for the default generator (Bernoulli arrivals, uniform service times) */
+    bool isDefault() const { return arrival_ == ArrivalProcess::Bernoulli && service_ == ServiceDistribution::Uniform; }
+    /** One line for run log headers, e.g. "mmpp (calm 0.05, burst 0.5 ...), pareto (...)" */
+    std::string describe() const;
+
+private:
+    ArrivalProcess arrival_{ArrivalProcess::Bernoulli};
+    ServiceDistribution service_{ServiceDistribution::Uniform};
+    int runTime_;
+    int threads_;           /**< generate(): 0 = one per core */
+    int percent_;           /**< bernoulli: per-cycle probability */
+    double rate_;           /**< poisson rate; mmpp calm rate; diurnal mean rate */
+    double burstRate_;
+    double calmCycles_;
+    double burstCycles_;
+    double period_;
+    double amplitude_;      /**< diurnal: fraction of rate_ */
+    int minService_;
+    int maxService_;
+    double mean_;
+    double sigma_;
+    double alpha_;
+    double paretoScale_;
+    uint64_t key_{0};
+    PhiloxStream stream_;   /**< arrival draws */
+    int count_{0};
+    bool burst_{true};      /**< mmpp: current state; the first call enters calm at cycle 0 */
+    double stateEnd_{0};    /**< mmpp: cycle the current state ends */
+
+    double uniform() { return philoxUniform(stream_()); }
+    int nextPoisson(double from, double end, double rate);
+    int positivePoisson(double rate);
+    int clampService(double x) const;
+};
+
+#endif /* WORKLOAD_H */
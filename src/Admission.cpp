@@ -0,0 +1,79 @@
+/**
+ * @file Admission.cpp
+ * @brief Implementation of AdmissionControl: queue bound, drop policies and RED.
+ */
+
+#include "Admission.h"
+#include "Philox.h"
+#include <algorithm>
+#include <sstream>
+
+namespace {
+
+constexpr uint32_t kEarlyDropStream = 3;  /**< block id = coin of req id (Workload uses streams 0-2) */
+
+} // namespace
+
+bool parseAdmissionPolicy(const std::string& s, AdmissionPolicy& p) {
+    if (s == "reject-new") p = AdmissionPolicy::RejectNew;
+    else if (s == "drop-oldest") p = AdmissionPolicy::DropOldest;
+    else if (s == "red") p = AdmissionPolicy::Red;
+    else return false;
+    return true;
+}
+
+bool parseRedSignal(const std::string& s, RedSignal& r) {
+    if (s == "depth") r = RedSignal::Depth;
+    else if (s == "age") r = RedSignal::Age;
+    else return false;
+    return true;
+}
+
+const char* shedReasonName(ShedReason r) {
+    switch (r) {
+    case ShedReason::QueueFull: return "queue-full";
+    case ShedReason::DropOldest: return "drop-oldest";
+    case ShedReason::EarlyDrop: return "early-drop";
+    case ShedReason::Timeout: return "timeout";
+    }
+    return "?";
+}
+
+AdmissionControl::AdmissionControl(const Config& cfg)
+    : maxDepth_(static_cast<size_t>(std::max(cfg.maxQueueDepth, 0))), timeout_(std::max(cfg.queueTimeout, 0)),
+      key_(cfg.seed) {
+    parseAdmissionPolicy(cfg.admissionPolicy, policy_);
+    parseRedSignal(cfg.redSignal, signal_);
+    double bound = signal_ == RedSignal::Depth ? static_cast<double>(maxDepth_) : timeout_;
+    redMax_ = cfg.redMax > 0 ? cfg.redMax : bound;
+    redMin_ = cfg.redMin > 0 ? std::min<double>(cfg.redMin, redMax_) : redMax_ / 2;
+    maxDrop_ = std::min(std::max(cfg.redMaxDropPercent, 0), 100) / 100.0;
+}
+
+AdmissionControl::Verdict AdmissionControl::admit(uint64_t id, size_t depth, int age) const {
+    if (maxDepth_ > 0 && depth >= maxDepth_)
+        return policy_ == AdmissionPolicy::DropOldest ? Verdict::DropOldest : Verdict::QueueFull;
+    if (policy_ != AdmissionPolicy::Red || redMax_ <= 0) return Verdict::Admit;
+    double s = signal_ == RedSignal::Depth ? static_cast<double>(depth) : age;
+    if (s < redMin_) return Verdict::Admit;
+    if (s >= redMax_) return Verdict::EarlyDrop;
+    // probability rises linearly from 0 at redMin_ to maxDrop_ at redMax_
+    double p = maxDrop_ * (s - redMin_) / (redMax_ - redMin_);
+    double coin = philoxUniform(philox4x32(key_, id, kEarlyDropStream).w[0]);
+    return coin < p ? Verdict::EarlyDrop : Verdict::Admit;
+}
+
+std::string AdmissionControl::describe() const {
+    std::ostringstream os;
+    if (maxDepth_ > 0) {
+        os << "max depth " << maxDepth_ << ", "
+           << (policy_ == AdmissionPolicy::DropOldest ? "drop-oldest" : "reject-new") << " when full";
+    } else {
+        os << "unbounded";
+    }
+    if (policy_ == AdmissionPolicy::Red)
+        os << "; red on " << (signal_ == RedSignal::Depth ? "depth " : "age ") << redMin_ << ".." << redMax_
+           << (signal_ == RedSignal::Age ? " cycles" : "") << " up to " << maxDrop_ * 100 << "%";
+    if (timeout_ > 0) os << "; timeout " << timeout_ << " cycles";
+    return os.str();
+}
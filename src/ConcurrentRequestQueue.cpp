@@ -0,0 +1,66 @@
+/**
+ * @file ConcurrentRequestQueue.cpp
+ * @brief Implementation of ConcurrentRequestQueue.
+ */
+
+#include "ConcurrentRequestQueue.h"
+
+ConcurrentRequestQueue::ConcurrentRequestQueue(size_t capacity) {
+    size_t cap = 2;
+    while (cap < capacity) cap *= 2;
+    cells_.reset(new Cell[cap]);
+    mask_ = cap - 1;
+    // cell i is free for the producer holding position i
+    for (size_t i = 0; i < cap; ++i) cells_[i].seq.store(i, std::memory_order_relaxed);
+}
+
+bool ConcurrentRequestQueue::try_enqueue(const Request& r) {
+    size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+        cell = &cells_[pos & mask_];
+        size_t seq = cell->seq.load(std::memory_order_acquire);
+        long diff = static_cast<long>(seq) - static_cast<long>(pos);
+        if (diff == 0) {
+            if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            return false;  // cell still holds a req from one lap ago
+        } else {
+            pos = enqueuePos_.load(std::memory_order_relaxed);
+        }
+    }
+    cell->req = r;
+    cell->seq.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool ConcurrentRequestQueue::try_dequeue(Request& out) {
+    size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+        cell = &cells_[pos & mask_];
+        size_t seq = cell->seq.load(std::memory_order_acquire);
+        long diff = static_cast<long>(seq) - static_cast<long>(pos + 1);
+        if (diff == 0) {
+            if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            return false;  // producer has not filled this cell yet
+        } else {
+            pos = dequeuePos_.load(std::memory_order_relaxed);
+        }
+    }
+    out = cell->req;
+    // free the cell for the producer one lap ahead
+    cell->seq.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+}
+
+size_t ConcurrentRequestQueue::size_approx() const {
+    size_t tail = enqueuePos_.load(std::memory_order_relaxed);
+    size_t head = dequeuePos_.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+}
+
+size_t ConcurrentRequestQueue::capacity() const {
+    return mask_ + 1;
+}
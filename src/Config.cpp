@@ -24,6 +24,13 @@ int parseInt(const std::string& s, int defaultVal) {
         return defaultVal;
     }
 }
+double parseDouble(const std::string& s, double defaultVal) {
+    try {
+        return std::stod(s);
+    } catch (...) {
+        return defaultVal;
+    }
+}
 unsigned int parseUInt(const std::string& s, unsigned int defaultVal) {
     try {
         return static_cast<unsigned int>(std::stoul(s));
@@ -32,6 +39,17 @@ unsigned int parseUInt(const std::string& s, unsigned int defaultVal) {
     }
 }
 
+void splitList(const std::string& val, std::vector<std::string>& out) {
+    size_t start = 0;
+    while (start < val.size()) {
+        size_t comma = val.find(',', start);
+        std::string one = trim(comma == std::string::npos ? val.substr(start) : val.substr(start, comma - start));
+        if (!one.empty()) out.push_back(one);
+        if (comma == std::string::npos) {break;}
+        start = comma + 1;
+    }
+}
+
 } // namespace
 
 bool Config::loadFromFile(const std::string& path) {
@@ -48,35 +66,79 @@ bool Config::loadFromFile(const std::string& path) {
         if (eq == std::string::npos) continue;
         std::string key = trim(line.substr(0, eq));
         std::string val = trim(line.substr(eq + 1));
-
-
-        // vals of confg variables
-        if (key == "initialServers") initialServers = parseInt(val, initialServers);
-        else if (key == "runTime") runTime = parseInt(val, runTime);
-        else if (key == "scaleCooldown") scaleCooldown = parseInt(val, scaleCooldown);
-        else if (key == "initialQueueSize") initialQueueSize = parseInt(val, initialQueueSize);
-        else if (key == "lowFactor") lowFactor = parseInt(val, lowFactor);
-        else if (key == "highFactor") highFactor = parseInt(val, highFactor);
-        else if (key == "minServiceTime") minServiceTime = parseInt(val, minServiceTime);
-        else if (key == "maxServiceTime") maxServiceTime = parseInt(val, maxServiceTime);
-        else if (key == "newRequestProbabilityPercent") newRequestProbabilityPercent = parseInt(val, newRequestProbabilityPercent);
-        else if (key == "seed") seed = parseUInt(val, seed);
-        else if (key == "logPath") logPath = val;
-        else if (key == "blockedRange" || key == "blockedRanges") {
-            size_t start = 0;
-            while (start < val.size()) {
-                size_t comma = val.find(',', start);
-                std::string one = trim(comma == std::string::npos ? val.substr(start) : val.substr(start, comma - start));
-                if (!one.empty()) blockedRanges.push_back(one);
-                if (comma == std::string::npos) {break;}
-                start = comma + 1;
-            }
-        }
+        set(key, val);
     }
     return true;
 }
 
 
+bool Config::set(const std::string& key, const std::string& val) {
+    if (key == "initialServers") initialServers = parseInt(val, initialServers);
+    else if (key == "runTime") runTime = parseInt(val, runTime);
+    else if (key == "scaleCooldown") scaleCooldown = parseInt(val, scaleCooldown);
+    else if (key == "initialQueueSize") initialQueueSize = parseInt(val, initialQueueSize);
+    else if (key == "lowFactor") lowFactor = parseInt(val, lowFactor);
+    else if (key == "highFactor") highFactor = parseInt(val, highFactor);
+    else if (key == "maxServers") maxServers = parseInt(val, maxServers);
+    else if (key == "minServiceTime") minServiceTime = parseInt(val, minServiceTime);
+    else if (key == "maxServiceTime") maxServiceTime = parseInt(val, maxServiceTime);
+    else if (key == "newRequestProbabilityPercent") newRequestProbabilityPercent = parseInt(val, newRequestProbabilityPercent);
+    else if (key == "arrivalProcess") arrivalProcess = val;
+    else if (key == "arrivalRate") arrivalRate = parseDouble(val, arrivalRate);
+    else if (key == "burstRate") burstRate = parseDouble(val, burstRate);
+    else if (key == "calmCycles") calmCycles = parseInt(val, calmCycles);
+    else if (key == "burstCycles") burstCycles = parseInt(val, burstCycles);
+    else if (key == "diurnalPeriod") diurnalPeriod = parseInt(val, diurnalPeriod);
+    else if (key == "diurnalAmplitudePercent") diurnalAmplitudePercent = parseInt(val, diurnalAmplitudePercent);
+    else if (key == "serviceDistribution") serviceDistribution = val;
+    else if (key == "serviceMean") serviceMean = parseDouble(val, serviceMean);
+    else if (key == "serviceSigma") serviceSigma = parseDouble(val, serviceSigma);
+    else if (key == "paretoAlpha") paretoAlpha = parseDouble(val, paretoAlpha);
+    else if (key == "queueDiscipline") queueDiscipline = val;
+    else if (key == "priorityJobType") priorityJobType = val;
+    else if (key == "streamingDeadline") streamingDeadline = parseInt(val, streamingDeadline);
+    else if (key == "processingDeadline") processingDeadline = parseInt(val, processingDeadline);
+    else if (key == "streamingWeight") streamingWeight = parseInt(val, streamingWeight);
+    else if (key == "processingWeight") processingWeight = parseInt(val, processingWeight);
+    else if (key == "maxQueueDepth") maxQueueDepth = parseInt(val, maxQueueDepth);
+    else if (key == "admissionPolicy") admissionPolicy = val;
+    else if (key == "redSignal") redSignal = val;
+    else if (key == "redMin") redMin = parseInt(val, redMin);
+    else if (key == "redMax") redMax = parseInt(val, redMax);
+    else if (key == "redMaxDropPercent") redMaxDropPercent = parseInt(val, redMaxDropPercent);
+    else if (key == "queueTimeout") queueTimeout = parseInt(val, queueTimeout);
+    else if (key == "generatorThreads") generatorThreads = parseInt(val, generatorThreads);
+    else if (key == "seed") seed = parseUInt(val, seed);
+    else if (key == "logPath") logPath = val;
+    else if (key == "logLevel") logLevel = val;
+    else if (key == "logFormat") logFormat = val;
+    else if (key == "dispatch") dispatch = val;
+    else if (key == "scaler") scaler = val;
+    else if (key == "scaleTargetUtilization") scaleTargetUtilization = parseInt(val, scaleTargetUtilization);
+    else if (key == "scaleSmoothingPercent") scaleSmoothingPercent = parseInt(val, scaleSmoothingPercent);
+    else if (key == "scaleDrainCycles") scaleDrainCycles = parseInt(val, scaleDrainCycles);
+    else if (key == "scaleMaxStep") scaleMaxStep = parseInt(val, scaleMaxStep);
+    else if (key == "provisionDelay") provisionDelay = parseInt(val, provisionDelay);
+    else if (key == "dispatchQueueLimit") dispatchQueueLimit = parseInt(val, dispatchQueueLimit);
+    else if (key == "metricsInterval") metricsInterval = parseInt(val, metricsInterval);
+    else if (key == "metricsFormat") metricsFormat = val;
+    else if (key == "metricsPath") metricsPath = val;
+    else if (key == "engine") engine = val;
+    else if (key == "parallelSwitch") parallelSwitch = parseInt(val, parallelSwitch ? 1 : 0) != 0;
+    else if (key == "threads") threads = parseInt(val, threads);
+    else if (key == "producers") producers = parseInt(val, producers);
+    else if (key == "workPerUnit") workPerUnit = parseInt(val, workPerUnit);
+    else if (key == "realtimeQueueCapacity") realtimeQueueCapacity = parseInt(val, realtimeQueueCapacity);
+    else if (key == "sweepThreads") sweepThreads = parseInt(val, sweepThreads);
+    else if (key == "blocklistFile") blocklistFile = val;
+    else if (key == "traceFile") traceFile = val;
+    else if (key == "serverClass" || key == "serverClasses") splitList(val, serverClasses);
+    else if (key == "blockedRange" || key == "blockedRanges") splitList(val, blockedRanges);
+    else if (key == "allowedRange" || key == "allowedRanges") splitList(val, allowedRanges);
+    else return false;
+    return true;
+}
+
 void Config::applyCommandLine(int argc, char* argv[]) {
 
     for (int i = 1; i < argc; ++i) {
@@ -92,12 +154,88 @@ void Config::applyCommandLine(int argc, char* argv[]) {
             lowFactor = parseInt(argv[++i], lowFactor);
         } else if (std::strcmp(argv[i], "--high") == 0 && i + 1 < argc) {
             highFactor = parseInt(argv[++i], highFactor);
+        } else if (std::strcmp(argv[i], "--max-servers") == 0 && i + 1 < argc) {
+            maxServers = parseInt(argv[++i], maxServers);
         } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
             seed = parseUInt(argv[++i], seed);
         } else if (std::strcmp(argv[i], "--config") == 0 && i + 1 < argc) {
             loadFromFile(argv[++i]);
         } else if (std::strcmp(argv[i], "--log") == 0 && i + 1 < argc) {
             logPath = argv[++i];
+        } else if (std::strncmp(argv[i], "--log-level=", 12) == 0) {
+            logLevel = argv[i] + 12;
+        } else if (std::strcmp(argv[i], "--log-level") == 0 && i + 1 < argc) {
+            logLevel = argv[++i];
+        } else if (std::strncmp(argv[i], "--log-format=", 13) == 0) {
+            logFormat = argv[i] + 13;
+        } else if (std::strcmp(argv[i], "--log-format") == 0 && i + 1 < argc) {
+            logFormat = argv[++i];
+        } else if (std::strncmp(argv[i], "--scaler=", 9) == 0) {
+            scaler = argv[i] + 9;
+        } else if (std::strcmp(argv[i], "--scaler") == 0 && i + 1 < argc) {
+            scaler = argv[++i];
+        } else if (std::strncmp(argv[i], "--arrivals=", 11) == 0) {
+            arrivalProcess = argv[i] + 11;
+        } else if (std::strcmp(argv[i], "--arrivals") == 0 && i + 1 < argc) {
+            arrivalProcess = argv[++i];
+        } else if (std::strcmp(argv[i], "--arrival-rate") == 0 && i + 1 < argc) {
+            arrivalRate = parseDouble(argv[++i], arrivalRate);
+        } else if (std::strncmp(argv[i], "--service-dist=", 15) == 0) {
+            serviceDistribution = argv[i] + 15;
+        } else if (std::strcmp(argv[i], "--service-dist") == 0 && i + 1 < argc) {
+            serviceDistribution = argv[++i];
+        } else if (std::strncmp(argv[i], "--queue-discipline=", 19) == 0) {
+            queueDiscipline = argv[i] + 19;
+        } else if (std::strcmp(argv[i], "--queue-discipline") == 0 && i + 1 < argc) {
+            queueDiscipline = argv[++i];
+        } else if (std::strcmp(argv[i], "--max-queue") == 0 && i + 1 < argc) {
+            maxQueueDepth = parseInt(argv[++i], maxQueueDepth);
+        } else if (std::strncmp(argv[i], "--admission=", 12) == 0) {
+            admissionPolicy = argv[i] + 12;
+        } else if (std::strcmp(argv[i], "--admission") == 0 && i + 1 < argc) {
+            admissionPolicy = argv[++i];
+        } else if (std::strcmp(argv[i], "--queue-timeout") == 0 && i + 1 < argc) {
+            queueTimeout = parseInt(argv[++i], queueTimeout);
+        } else if (std::strcmp(argv[i], "--gen-threads") == 0 && i + 1 < argc) {
+            generatorThreads = parseInt(argv[++i], generatorThreads);
+        } else if (std::strcmp(argv[i], "--server-class") == 0 && i + 1 < argc) {
+            splitList(argv[++i], serverClasses);
+        } else if (std::strcmp(argv[i], "--provision-delay") == 0 && i + 1 < argc) {
+            provisionDelay = parseInt(argv[++i], provisionDelay);
+        } else if (std::strncmp(argv[i], "--dispatch=", 11) == 0) {
+            dispatch = argv[i] + 11;
+        } else if (std::strcmp(argv[i], "--dispatch") == 0 && i + 1 < argc) {
+            dispatch = argv[++i];
+        } else if (std::strcmp(argv[i], "--metrics-interval") == 0 && i + 1 < argc) {
+            metricsInterval = parseInt(argv[++i], metricsInterval);
+        } else if (std::strncmp(argv[i], "--metrics-format=", 17) == 0) {
+            metricsFormat = argv[i] + 17;
+        } else if (std::strcmp(argv[i], "--metrics-format") == 0 && i + 1 < argc) {
+            metricsFormat = argv[++i];
+        } else if (std::strcmp(argv[i], "--metrics-out") == 0 && i + 1 < argc) {
+            metricsPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--blocklist") == 0 && i + 1 < argc) {
+            blocklistFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            traceFile = argv[++i];
+        } else if (std::strncmp(argv[i], "--engine=", 9) == 0) {
+            engine = argv[i] + 9;
+        } else if (std::strcmp(argv[i], "--engine") == 0 && i + 1 < argc) {
+            engine = argv[++i];
+        } else if (std::strcmp(argv[i], "--serial-switch") == 0) {
+            parallelSwitch = false;
+        } else if (std::strcmp(argv[i], "--sweep") == 0 && i + 1 < argc) {
+            sweepPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            sweepThreads = parseInt(argv[++i], sweepThreads);
+        } else if (std::strcmp(argv[i], "--realtime") == 0) {
+            realtime = true;
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = parseInt(argv[++i], threads);
+        } else if (std::strcmp(argv[i], "--producers") == 0 && i + 1 < argc) {
+            producers = parseInt(argv[++i], producers);
+        } else if (std::strcmp(argv[i], "--work") == 0 && i + 1 < argc) {
+            workPerUnit = parseInt(argv[++i], workPerUnit);
         }
     }
 }
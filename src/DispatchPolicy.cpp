@@ -0,0 +1,227 @@
+/**
+ * @file DispatchPolicy.cpp
+ * @brief Dispatch policies: lowest-idle, round-robin, least-work, power-of-two, JIQ.
+ */
+
+#include "DispatchPolicy.h"
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <functional>
+#include <queue>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr unsigned int kSeedSalt = 0x9E3779B9u;  /**< policy stream differs from the arrival stream for the same seed */
+
+/** Oldest behavior: the lowest-numbered idle server takes the oldest req */
+class LowestIdlePolicy : public DispatchPolicy {
+public:
+    bool usesServerQueues() const override { return false; }
+};
+
+/** Idle servers take turns: the next idle one after the last server picked */
+class RoundRobinPolicy : public DispatchPolicy {
+public:
+    bool usesServerQueues() const override { return false; }
+
+    long pickIdle(const ServerSet& idle) override {
+        long i = idle.next(static_cast<size_t>(last_ + 1));
+        if (i < 0) i = idle.first();
+        last_ = i;
+        return i;
+    }
+
+private:
+    long last_{-1};
+};
+
+/**
+ * Each req goes to the server that will finish its current work first. Service times
+ * are known, so a server's finish time only changes when it is given a req: a min-heap
+ * of finish times (stale entries dropped on the way out) gives O(log n) routing. A
+ * server with k slots at speed s works through its queue k x s times as fast.
+ */
+class LeastWorkPolicy : public DispatchPolicy {
+public:
+    bool usesServerQueues() const override { return true; }
+
+    long route(const Request& r, int currentTime) override {
+        while (!heap_.empty()) {
+            auto [end, i] = heap_.top();
+            heap_.pop();
+            if (!active_[i] || end != workEnd_[i]) continue;
+            workEnd_[i] = std::max<long long>(end, currentTime) + work(i, r);
+            heap_.push({workEnd_[i], i});
+            return static_cast<long>(i);
+        }
+        return -1;
+    }
+
+    void requestDropped(size_t i, const Request& r) override {
+        workEnd_[i] -= work(i, r);
+        if (active_[i]) heap_.push({workEnd_[i], i});
+    }
+
+    void serverAdded(size_t i, const WebServer& s, int currentTime) override {
+        if (i >= active_.size()) {
+            active_.resize(i + 1, 0);
+            workEnd_.resize(i + 1, 0);
+            rate_.resize(i + 1, 1.0);
+        }
+        active_[i] = 1;
+        rate_[i] = s.slots() * s.speed();
+        workEnd_[i] = std::max<long long>(workEnd_[i], currentTime);  // a drained server may still hold work
+        heap_.push({workEnd_[i], i});
+    }
+
+    void serverRemoved(size_t i) override { active_[i] = 0; }
+
+private:
+    std::vector<char> active_;
+    std::vector<long long> workEnd_;  /**< cycle at which server i runs out of work */
+    std::vector<double> rate_;        /**< service time server i clears per cycle */
+    std::priority_queue<std::pair<long long, size_t>, std::vector<std::pair<long long, size_t>>,
+                        std::greater<std::pair<long long, size_t>>> heap_;
+
+    /** Cycles req r adds to server i's finish time */
+    long long work(size_t i, const Request& r) const {
+        long long w = r.serviceTime;
+        if (rate_[i] != 1.0) w = std::max(1LL, static_cast<long long>(std::ceil(w / rate_[i])));
+        return w;
+    }
+};
+
+/** Base for the randomized policies: active servers in an array for O(1) sampling */
+class SampledPolicy : public DispatchPolicy {
+public:
+    explicit SampledPolicy(unsigned int seed) : rng_(seed ^ kSeedSalt) {}
+
+    void seed(unsigned int seed) override { rng_.seed(seed ^ kSeedSalt); }
+
+    bool usesServerQueues() const override { return true; }
+
+    void serverAdded(size_t i, const WebServer& s, int currentTime) override {
+        (void)currentTime;
+        if (i >= pos_.size()) {
+            pos_.resize(i + 1, -1);
+            held_.resize(i + 1, 0);
+            slots_.resize(i + 1, 1);
+            weight_.resize(i + 1, 1.0);
+        }
+        pos_[i] = static_cast<long>(list_.size());
+        list_.push_back(i);
+        slots_[i] = s.slots();
+        weight_[i] = s.slots() * s.speed();
+    }
+
+    void serverRemoved(size_t i) override {
+        size_t p = static_cast<size_t>(pos_[i]);
+        list_[p] = list_.back();
+        pos_[list_[p]] = static_cast<long>(p);
+        list_.pop_back();
+        pos_[i] = -1;
+    }
+
+    void requestDone(size_t i, bool idle) override {
+        (void)idle;
+        held_[i]--;
+    }
+
+    void requestDropped(size_t i, const Request& r) override {
+        (void)r;
+        held_[i]--;
+    }
+
+protected:
+    std::mt19937 rng_;         /**< own stream: the arrival stream is unchanged by the policy */
+    std::vector<size_t> list_;  /**< active servers */
+    std::vector<long> pos_;     /**< index in list_, -1 if inactive */
+    std::vector<int> held_;     /**< reqs routed to server i and not yet completed */
+    std::vector<int> slots_;
+    std::vector<double> weight_;  /**< capacity: slots x speed */
+
+    size_t sample() {
+        return list_[std::uniform_int_distribution<size_t>(0, list_.size() - 1)(rng_)];
+    }
+};
+
+/** Two distinct random servers; the one holding fewer reqs per unit of capacity gets it */
+class PowerOfTwoPolicy : public SampledPolicy {
+public:
+    using SampledPolicy::SampledPolicy;
+
+    long route(const Request& r, int currentTime) override {
+        (void)r;
+        (void)currentTime;
+        if (list_.empty()) return -1;
+        size_t a = sample();
+        size_t pick = a;
+        if (list_.size() > 1) {
+            // second choice from the other n - 1 servers
+            size_t k = std::uniform_int_distribution<size_t>(0, list_.size() - 2)(rng_);
+            if (k >= static_cast<size_t>(pos_[a])) ++k;
+            size_t b = list_[k];
+            if (held_[b] * weight_[a] < held_[a] * weight_[b]) pick = b;
+        }
+        held_[pick]++;
+        return static_cast<long>(pick);
+    }
+};
+
+/**
+ * Join-idle-queue: servers announce each slot that goes idle and the next req goes to
+ * the longest-idle one. With no idle slot a req goes to a random server only if its
+ * queue is below the limit; otherwise reqs wait centrally until a slot frees up.
+ */
+class JoinIdleQueuePolicy : public SampledPolicy {
+public:
+    JoinIdleQueuePolicy(unsigned int seed, int limit) : SampledPolicy(seed), limit_(std::max(limit, 0)) {}
+
+    long route(const Request& r, int currentTime) override {
+        (void)r;
+        (void)currentTime;
+        while (!idleQueue_.empty()) {
+            size_t i = idleQueue_.front();
+            idleQueue_.pop_front();
+            // entries of servers since scaled down or filled up are stale
+            if (pos_[i] < 0 || held_[i] >= slots_[i]) continue;
+            held_[i]++;
+            return static_cast<long>(i);
+        }
+        if (list_.empty()) return -1;
+        size_t j = sample();
+        if (held_[j] >= slots_[j] + limit_) return -1;  // every slot running plus limit_ waiting
+        held_[j]++;
+        return static_cast<long>(j);
+    }
+
+    void serverAdded(size_t i, const WebServer& s, int currentTime) override {
+        SampledPolicy::serverAdded(i, s, currentTime);
+        for (int k = s.freeSlots(); k > 0; --k) idleQueue_.push_back(i);
+    }
+
+    void requestDone(size_t i, bool idle) override {
+        SampledPolicy::requestDone(i, idle);
+        if (idle) idleQueue_.push_back(i);
+    }
+
+private:
+    int limit_;
+    std::deque<size_t> idleQueue_;
+};
+
+} // namespace
+
+std::unique_ptr<DispatchPolicy> makeDispatchPolicy(const Config& cfg) {
+    unsigned int seed = cfg.seed;
+    if (cfg.dispatch == "lowest-idle") return std::make_unique<LowestIdlePolicy>();
+    if (cfg.dispatch == "round-robin") return std::make_unique<RoundRobinPolicy>();
+    if (cfg.dispatch == "least-work") return std::make_unique<LeastWorkPolicy>();
+    if (cfg.dispatch == "power-of-two") return std::make_unique<PowerOfTwoPolicy>(seed);
+    if (cfg.dispatch == "jiq") return std::make_unique<JoinIdleQueuePolicy>(seed, cfg.dispatchQueueLimit);
+    return nullptr;
+}
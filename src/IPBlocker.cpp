@@ -4,10 +4,14 @@
  */
 
 #include "IPBlocker.h"
-#include <sstream>
-#include <cstdlib>
 #include <algorithm>
-#include <cctype>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define IPBLOCKER_X86_SIMD 1
+#include <immintrin.h>
+#endif
 
 namespace {
 
@@ -18,59 +22,394 @@ std::string trim(const std::string& s) {
     return s.substr(start, end == std::string::npos ? std::string::npos : end - start + 1);
 }
 
+/** Parse "a.b.c.d" from [p, end); returns pointer past the address or nullptr */
+const char* parseDottedQuad(const char* p, const char* end, uint32_t& out) {
+    uint32_t result = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (i > 0) {
+            if (p == end || *p != '.') return nullptr;
+            ++p;
+        }
+        int octet = 0;
+        int digits = 0;
+        while (p != end && *p >= '0' && *p <= '9' && digits < 3) {
+            octet = octet * 10 + (*p - '0');
+            ++p;
+            ++digits;
+        }
+        if (digits == 0 || octet > 255) return nullptr;
+        result = (result << 8) | static_cast<uint32_t>(octet);
+    }
+    out = result;
+    return p;
+}
+
+bool tableLookup(const uint32_t* tbl24, const uint64_t* tbl8, uint32_t ip) {
+    uint32_t e = tbl24[ip >> 8];
+    if (e < 2) return e != 0;
+    const uint64_t* group = tbl8 + static_cast<size_t>(e - 2) * 4;
+    uint32_t low = ip & 0xFF;
+    return (group[low >> 6] >> (low & 63)) & 1;
+}
+
+#ifdef IPBLOCKER_X86_SIMD
+
+bool cpuHasAvx2() {
+    static const bool has = __builtin_cpu_supports("avx2");
+    return has;
+}
+
+// In-range test per interval: (ip - lo) <=u (hi - lo). Lanes only have signed compares,
+// so both sides are biased by 0x80000000; a lane is blocked unless it is outside all.
+__attribute__((target("avx2")))
+void filterSpansAvx2(const uint32_t* ips, size_t count, const uint32_t* lo, const uint32_t* span,
+                     size_t n, uint64_t* out, size_t& done) {
+    const __m256i bias = _mm256_set1_epi32(INT32_MIN);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ips + i));
+        __m256i outside = _mm256_set1_epi32(-1);
+        for (size_t k = 0; k < n; ++k) {
+            __m256i d = _mm256_xor_si256(_mm256_sub_epi32(v, _mm256_set1_epi32(static_cast<int>(lo[k]))), bias);
+            outside = _mm256_and_si256(outside, _mm256_cmpgt_epi32(d, _mm256_set1_epi32(static_cast<int>(span[k]))));
+        }
+        uint64_t bits = ~static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(outside))) & 0xFFu;
+        out[i >> 6] |= bits << (i & 63);
+    }
+    done = i;
+}
+
+void filterSpansSse2(const uint32_t* ips, size_t count, const uint32_t* lo, const uint32_t* span,
+                     size_t n, uint64_t* out, size_t& done) {
+    const __m128i bias = _mm_set1_epi32(INT32_MIN);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ips + i));
+        __m128i outside = _mm_set1_epi32(-1);
+        for (size_t k = 0; k < n; ++k) {
+            __m128i d = _mm_xor_si128(_mm_sub_epi32(v, _mm_set1_epi32(static_cast<int>(lo[k]))), bias);
+            outside = _mm_and_si128(outside, _mm_cmpgt_epi32(d, _mm_set1_epi32(static_cast<int>(span[k]))));
+        }
+        uint64_t bits = ~static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(outside))) & 0xFu;
+        out[i >> 6] |= bits << (i & 63);
+    }
+    done = i;
+}
+
+// Gathers 8 first-level entries at once; lanes that point into a /25../32 group
+// (entry >= 2) are resolved one by one.
+__attribute__((target("avx2")))
+void filterTableAvx2(const uint32_t* ips, size_t count, const uint32_t* tbl24, const uint64_t* tbl8,
+                     uint64_t* out, size_t& done) {
+    const __m256i one = _mm256_set1_epi32(1);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ips + i));
+        __m256i e = _mm256_i32gather_epi32(reinterpret_cast<const int*>(tbl24), _mm256_srli_epi32(v, 8), 4);
+        uint64_t bits = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(e, one))));
+        uint32_t nested = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(e, one))));
+        while (nested) {
+            int lane = __builtin_ctz(nested);
+            nested &= nested - 1;
+            if (tableLookup(tbl24, tbl8, ips[i + static_cast<size_t>(lane)])) bits |= uint64_t{1} << lane;
+        }
+        out[i >> 6] |= bits << (i & 63);
+    }
+    done = i;
+}
+
+#endif
+
 } // namespace
 
 void IPBlocker::addBlockedRange(const std::string& cidrOrIp) {
-    std::string s = trim(cidrOrIp);
-    if (!s.empty()) blockedRanges_.push_back(s);
+    addRange(cidrOrIp, Action::Deny);
+    rebuild();
+}
+
+void IPBlocker::addBlockedRanges(const std::vector<std::string>& ranges) {
+    for (const auto& r : ranges) addRange(r, Action::Deny);
+    rebuild();
+}
+
+void IPBlocker::addAllowedRange(const std::string& cidrOrIp) {
+    addRange(cidrOrIp, Action::Allow);
+    rebuild();
+}
+
+void IPBlocker::addAllowedRanges(const std::vector<std::string>& ranges) {
+    for (const auto& r : ranges) addRange(r, Action::Allow);
+    rebuild();
+}
+
+bool IPBlocker::loadBlocklistFile(const std::string& path, size_t* loaded) {
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+
+    auto isSpace = [](char c) { return c == ' ' || c == '\t' || c == '\r'; };
+    auto startsWithWord = [&](const char* p, const char* end, const char* word, size_t len) {
+        return static_cast<size_t>(end - p) > len && std::memcmp(p, word, len) == 0 && isSpace(p[len]);
+    };
+    size_t count = 0;
+    auto parseLine = [&](const char* p, const char* end) {
+        while (p != end && isSpace(*p)) ++p;
+        if (p == end || *p == '#' || *p == ';') return;
+        Action action = Action::Deny;
+        if (*p == '!') {
+            action = Action::Allow;
+            ++p;
+        } else if (startsWithWord(p, end, "allow", 5)) {
+            action = Action::Allow;
+            p += 5;
+        } else if (startsWithWord(p, end, "deny", 4)) {
+            p += 4;
+        }
+        while (p != end && isSpace(*p)) ++p;
+        const char* tok = p;
+        while (p != end && !isSpace(*p) && *p != ';' && *p != '#' && *p != ',') ++p;
+        Rule r{};
+        if (parseRule(tok, p, action, r)) {
+            rules_.push_back(r);
+            count++;
+        }
+    };
+
+    // stream the feed in 1MB blocks; a partial trailing line carries into the next block
+    std::vector<char> buf(1 << 20);
+    size_t carry = 0;
+    for (;;) {
+        size_t n = std::fread(buf.data() + carry, 1, buf.size() - carry, f);
+        const char* p = buf.data();
+        const char* end = p + carry + n;
+        if (n == 0) {
+            if (p != end) parseLine(p, end);
+            break;
+        }
+        const char* nl;
+        while ((nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)))) != nullptr) {
+            parseLine(p, nl);
+            p = nl + 1;
+        }
+        carry = static_cast<size_t>(end - p);
+        if (carry == buf.size()) carry = 0;  // absurdly long line: drop it
+        std::memmove(buf.data(), p, carry);
+    }
+    std::fclose(f);
+    rebuild();
+    if (loaded) *loaded = count;
+    return true;
 }
 
 bool IPBlocker::isBlocked(const std::string& ip) const {
-    for (const auto& range : blockedRanges_) {
-        if (ipMatchesRange(ip, range)) return true;
+    uint32_t v = 0;
+    if (!parseIp(ip, v)) return false;
+    return isBlocked(v);
+}
+
+bool IPBlocker::isBlocked(uint32_t ip) const {
+    if (!tbl24_.empty()) return tableLookup(tbl24_.data(), tbl8_.data(), ip);
+    // first interval starting after ip; the candidate is the one before it
+    auto it = std::upper_bound(intervals_.begin(), intervals_.end(), ip,
+                               [](uint32_t v, const Interval& iv) { return v < iv.lo; });
+    if (it == intervals_.begin()) return false;
+    --it;
+    return ip <= it->hi;
+}
+
+void IPBlocker::filterBatch(const uint32_t* ips, size_t count, uint64_t* blocked) const {
+    std::fill(blocked, blocked + (count + 63) / 64, 0);
+    size_t done = 0;
+    if (!tbl24_.empty()) {
+#ifdef IPBLOCKER_X86_SIMD
+        if (cpuHasAvx2()) filterTableAvx2(ips, count, tbl24_.data(), tbl8_.data(), blocked, done);
+#endif
+    } else if (intervals_.empty()) {
+        return;
+    } else if (!simdLo_.empty()) {
+#ifdef IPBLOCKER_X86_SIMD
+        if (cpuHasAvx2())
+            filterSpansAvx2(ips, count, simdLo_.data(), simdSpan_.data(), simdLo_.size(), blocked, done);
+        else
+            filterSpansSse2(ips, count, simdLo_.data(), simdSpan_.data(), simdLo_.size(), blocked, done);
+#endif
+    }
+    for (size_t i = done; i < count; ++i) {
+        if (isBlocked(ips[i])) blocked[i >> 6] |= uint64_t{1} << (i & 63);
     }
-    return false;
 }
 
 const std::vector<std::string>& IPBlocker::getBlockedRanges() const {
     return blockedRanges_;
 }
 
+const std::vector<std::string>& IPBlocker::getAllowedRanges() const {
+    return allowedRanges_;
+}
 
+size_t IPBlocker::ruleCount() const {
+    return rules_.size();
+}
 
-bool IPBlocker::ipMatchesRange(const std::string& ip, const std::string& range) {
-    size_t slash = range.find('/');
-    if (slash == std::string::npos) {
-        return ip == range;
-    }
-    std::string baseIp = range.substr(0, slash);
-    std::string prefixLenStr = range.substr(slash + 1);
+bool IPBlocker::parseIp(const std::string& ip, uint32_t& out) {
+    const char* end = ip.data() + ip.size();
+    uint32_t v = 0;
+    if (parseDottedQuad(ip.data(), end, v) != end) return false;
+    out = v;
+    return true;
+}
+
+std::string IPBlocker::ipToString(uint32_t ip) {
+    return std::to_string(ip >> 24) + '.' + std::to_string((ip >> 16) & 0xFF) + '.' +
+           std::to_string((ip >> 8) & 0xFF) + '.' + std::to_string(ip & 0xFF);
+}
+
+bool IPBlocker::parseRule(const char* p, const char* end, Action action, Rule& out) {
+    uint32_t base = 0;
+    p = parseDottedQuad(p, end, base);
+    if (!p) return false;
     int prefixLen = 32;
-    try {
-        prefixLen = std::stoi(prefixLenStr);
-    } catch (...) {
-        return false;
+    if (p != end) {
+        if (*p != '/') return false;
+        ++p;
+        if (p == end) return false;
+        prefixLen = 0;
+        for (; p != end; ++p) {
+            if (*p < '0' || *p > '9') return false;
+            prefixLen = prefixLen * 10 + (*p - '0');
+            if (prefixLen > 32) return false;
+        }
     }
-    if (prefixLen < 0 || prefixLen > 32) return false;
-    unsigned int ipVal = ipToInt(ip);
-    unsigned int baseVal = ipToInt(baseIp);
-    unsigned int mask = prefixLen == 0 ? 0 : (0xFFFFFFFFu << (32 - prefixLen));
-    return (ipVal & mask) == (baseVal & mask);
+    uint32_t mask = prefixLen == 0 ? 0 : (0xFFFFFFFFu << (32 - prefixLen));
+    out.base = base & mask;
+    out.len = static_cast<uint8_t>(prefixLen);
+    out.action = action;
+    return true;
 }
 
+void IPBlocker::addRange(const std::string& cidrOrIp, Action action) {
+    std::string s = trim(cidrOrIp);
+    if (s.empty()) return;
+    (action == Action::Deny ? blockedRanges_ : allowedRanges_).push_back(s);
+    Rule r{};
+    if (parseRule(s.data(), s.data() + s.size(), action, r)) rules_.push_back(r);
+}
 
-unsigned int IPBlocker::ipToInt(const std::string& ip) {
-    unsigned int result = 0;
-    std::string s = ip;
-    for (int i = 0; i < 4; ++i) {
-        size_t dot = s.find('.');
-        std::string part = dot == std::string::npos ? s : s.substr(0, dot);
-        try { int octet = std::stoi(part);
-            if (octet < 0 || octet > 255) { return 0;}
-            result = (result << 8) | (unsigned int)(octet & 0xFF);
-        } catch (...) { return 0;}
-        if (dot == std::string::npos) { break;}
-        s = s.substr(dot + 1);
+void IPBlocker::rebuild() {
+    // Stable LSD radix sort by (base, len): passes on len, low and high half of base.
+    // Stability keeps insertion order among identical prefixes, so the last one wins.
+    std::vector<Rule> sorted(rules_);
+    std::vector<Rule> tmp(sorted.size());
+    std::vector<size_t> count(size_t{1} << 16);
+    auto pass = [&](auto digit, size_t buckets) {
+        std::fill(count.begin(), count.begin() + static_cast<std::ptrdiff_t>(buckets), 0);
+        for (const Rule& r : sorted) count[digit(r)]++;
+        size_t sum = 0;
+        for (size_t b = 0; b < buckets; ++b) {
+            size_t c = count[b];
+            count[b] = sum;
+            sum += c;
+        }
+        for (const Rule& r : sorted) tmp[count[digit(r)]++] = r;
+        sorted.swap(tmp);
+    };
+    pass([](const Rule& r) { return static_cast<size_t>(r.len); }, 33);
+    pass([](const Rule& r) { return static_cast<size_t>(r.base & 0xFFFF); }, size_t{1} << 16);
+    pass([](const Rule& r) { return static_cast<size_t>(r.base >> 16); }, size_t{1} << 16);
+    std::vector<Rule>().swap(tmp);
+
+    size_t kept = 0;
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        if (i + 1 < sorted.size() && sorted[i].base == sorted[i + 1].base && sorted[i].len == sorted[i + 1].len)
+            continue;
+        sorted[kept++] = sorted[i];
+    }
+    sorted.resize(kept);
+
+    buildIntervals(sorted);
+    simdLo_.clear();
+    simdSpan_.clear();
+    if (intervals_.size() <= kSimdMaxIntervals) {
+        for (const Interval& iv : intervals_) {
+            simdLo_.push_back(iv.lo);
+            simdSpan_.push_back((iv.hi - iv.lo) ^ 0x80000000u);
+        }
+    }
+    if (sorted.size() >= kLpmTableMinRules) {
+        // counting sort by prefix length (0..32)
+        size_t start[34] = {};
+        for (const Rule& r : sorted) start[r.len + 1]++;
+        for (int len = 1; len < 34; ++len) start[len] += start[len - 1];
+        std::vector<Rule> byLength(sorted.size());
+        for (const Rule& r : sorted) byLength[start[r.len]++] = r;
+        buildLpmTable(byLength);
+    } else {
+        std::vector<uint32_t>().swap(tbl24_);
+        std::vector<uint64_t>().swap(tbl8_);
+    }
+}
+
+void IPBlocker::buildIntervals(const std::vector<Rule>& sorted) {
+    // Prefixes are either nested or disjoint, so a sweep with a stack of the enclosing
+    // prefixes resolves longest-prefix-wins into flat runs; only blocked runs are kept.
+    intervals_.clear();
+    auto emit = [this](uint64_t lo, uint64_t hi, Action action) {
+        if (lo > hi || action != Action::Deny) return;
+        if (!intervals_.empty() && static_cast<uint64_t>(intervals_.back().hi) + 1 == lo)
+            intervals_.back().hi = static_cast<uint32_t>(hi);
+        else
+            intervals_.push_back({static_cast<uint32_t>(lo), static_cast<uint32_t>(hi)});
+    };
+    struct Open {
+        uint64_t hi;
+        Action action;
+    };
+    std::vector<Open> open;
+    uint64_t cursor = 0;
+    for (const Rule& r : sorted) {
+        uint64_t lo = r.base;
+        uint64_t hi = lo + ((r.len == 0 ? (uint64_t{1} << 32) : (uint64_t{1} << (32 - r.len)))) - 1;
+        while (!open.empty() && open.back().hi < lo) {
+            emit(cursor, open.back().hi, open.back().action);
+            cursor = open.back().hi + 1;
+            open.pop_back();
+        }
+        if (!open.empty() && cursor < lo) emit(cursor, lo - 1, open.back().action);
+        cursor = lo;
+        open.push_back({hi, r.action});
+    }
+    while (!open.empty()) {
+        emit(cursor, open.back().hi, open.back().action);
+        cursor = open.back().hi + 1;
+        open.pop_back();
+    }
+}
+
+void IPBlocker::buildLpmTable(const std::vector<Rule>& byLength) {
+    // painting shorter prefixes first lets longer ones overwrite them (longest wins)
+    tbl24_.assign(size_t{1} << 24, 0);
+    tbl8_.clear();
+    for (const Rule& r : byLength) {
+        uint32_t blocked = r.action == Action::Deny ? 1 : 0;
+        if (r.len <= 24) {
+            size_t first = r.base >> 8;
+            size_t count = size_t{1} << (24 - r.len);
+            std::fill(tbl24_.begin() + static_cast<std::ptrdiff_t>(first),
+                      tbl24_.begin() + static_cast<std::ptrdiff_t>(first + count), blocked);
+            continue;
+        }
+        uint32_t& e = tbl24_[r.base >> 8];
+        if (e < 2) {
+            uint64_t fill = e ? ~uint64_t{0} : 0;
+            e = static_cast<uint32_t>(tbl8_.size() / 4) + 2;
+            tbl8_.insert(tbl8_.end(), 4, fill);
+        }
+        uint64_t* group = &tbl8_[static_cast<size_t>(e - 2) * 4];
+        uint32_t lo = r.base & 0xFF;
+        uint32_t count = 1u << (32 - r.len);
+        for (uint32_t b = lo; b < lo + count; ++b) {
+            uint64_t bit = uint64_t{1} << (b & 63);
+            if (blocked) group[b >> 6] |= bit;
+            else group[b >> 6] &= ~bit;
+        }
     }
-    return result;
 }
@@ -0,0 +1,43 @@
+/**
+ * @file LatencyHistogram.cpp
+ * @brief Implementation of LatencyHistogram: merge, percentiles, summary line.
+ */
+
+#include "LatencyHistogram.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < kBuckets; ++i) counts_[i] += other.counts_[i];
+    count_ += other.count_;
+    sum_ += other.sum_;
+    max_ = std::max(max_, other.max_);
+}
+
+int64_t LatencyHistogram::bucketTop(size_t i) {
+    if (i < static_cast<size_t>(kExact)) return static_cast<int64_t>(i);
+    size_t j = i - static_cast<size_t>(kExact);
+    int shift = static_cast<int>(j / kHalf) + 1;
+    int64_t offset = static_cast<int64_t>(j % kHalf);
+    return ((kHalf + offset + 1) << shift) - 1;
+}
+
+int64_t LatencyHistogram::percentile(double pct) const {
+    if (count_ == 0) return 0;
+    // rank of the sample, 1-based: the smallest n with n >= pct% of the count
+    uint64_t rank = static_cast<uint64_t>(std::ceil(pct / 100.0 * static_cast<double>(count_)));
+    rank = std::min(std::max<uint64_t>(rank, 1), count_);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        seen += counts_[i];
+        if (seen >= rank) return std::min(bucketTop(i), max_);
+    }
+    return max_;
+}
+
+void LatencyHistogram::writeTo(std::ostream& os) const {
+    os << "p50 " << percentile(50) << " p90 " << percentile(90) << " p99 " << percentile(99)
+       << " p99.9 " << percentile(99.9) << " max " << max_ << " mean " << std::fixed
+       << std::setprecision(1) << mean() << " (n=" << count_ << ")";
+}
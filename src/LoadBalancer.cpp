@@ -4,46 +4,231 @@
  */
 
 #include "LoadBalancer.h"
+#include "ConcurrentRequestQueue.h"
 #include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <thread>
+#include <atomic>
+#include <chrono>
 
 namespace {
 
+constexpr int kScaleDownSlackPercent = 10;  /**< predictive: capacity kept above target before removing */
+constexpr int kSampleMicros = 100;   /**< real-time queue depth sampling period */
+
 std::string ansiGreen()  { return "\033[32m"; }
 std::string ansiRed()    { return "\033[31m"; }
 std::string ansiYellow() { return "\033[33m"; }
 std::string ansiCyan()   { return "\033[36m"; }
 std::string ansiReset()  { return "\033[0m"; }
 
-std::string randomIp(std::mt19937& rng) {
-    std::uniform_int_distribution<int> u(0, 255);
-    std::ostringstream os;
-    os << u(rng) << '.' << u(rng) << '.' << u(rng) << '.' << u(rng);
-    return os.str();
+
+/** Real-time worker counters, one cache line per thread */
+struct alignas(64) WorkerStats {
+    size_t completed{0};
+    size_t emptyPolls{0};
+    long long busyNs{0};
+    uint64_t sink{0};
+};
+
+/** Real-time producer counters, one cache line per thread */
+struct alignas(64) ProducerStats {
+    size_t generated{0};
+    size_t blocked{0};
+    size_t fullStalls{0};
+};
+
+/** Stand-in for serving a req: a dependent xorshift chain the compiler cannot drop */
+uint64_t burnCpu(uint64_t x, long long iterations) {
+    for (long long i = 0; i < iterations; ++i) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+    }
+    return x;
 }
 
 } // namespace
 
-LoadBalancer::LoadBalancer(const Config& cfg) : cfg_(cfg) {
+LoadBalancer::LoadBalancer(const Config& cfg) : cfg_(cfg), workload_(cfg), admission_(cfg), rQ_(cfg, pool_) {
+    policy_ = makeDispatchPolicy(cfg_);
+    if (!policy_) {
+        cfg_.dispatch = "lowest-idle";
+        policy_ = makeDispatchPolicy(cfg_);
+    }
     if (cfg_.initialQueueSize <= 0) {  cfg_.initialQueueSize = cfg_.initialServers * 100;}
-    for (int i = 0; i < cfg_.initialServers; ++i) addServer();
+    if (cfg_.realtime && cfg_.threads > 0) cfg_.initialServers = cfg_.threads;  // one worker thread per server
+    for (const std::string& spec : cfg_.serverClasses) {
+        ServerClass c;
+        if (parseServerClass(spec, c)) classes_.push_back(c);
+    }
+    if (classes_.empty() || cfg_.realtime) {
+        classes_.assign(1, ServerClass());
+        classes_[0].count = cfg_.initialServers;
+    } else {
+        cfg_.initialServers = 0;
+        for (const ServerClass& c : classes_) cfg_.initialServers += c.count;
+    }
+    for (size_t c = 0; c < classes_.size(); ++c) classOrder_.push_back(static_cast<int>(c));
+    std::stable_sort(classOrder_.begin(), classOrder_.end(),
+                     [&](int a, int b) { return classes_[static_cast<size_t>(a)].speed > classes_[static_cast<size_t>(b)].speed; });
+    classServers_.assign(classes_.size(), 0);
+    idleByClass_.resize(classes_.size());
+    predictive_ = cfg_.scaler == "predictive";
+    // the initial fleet starts warm
+    for (size_t c = 0; c < classes_.size(); ++c)
+        for (int i = 0; i < classes_[c].count; ++i) provisionServer(0, static_cast<int>(c));
+    if (!cfg_.realtime) metrics_.reset(cfg_.metricsInterval, cfg_.runTime);
 }
 
 void LoadBalancer::addServer() {
-    int id = static_cast<int>(servers_.size()) + 1;
-    servers_.push_back(std::make_unique<WebServer>(id));
+    provisionServer(cfg_.provisionDelay, scaleUpClass());
 }
 
-void LoadBalancer::removeServer() {
-    if (servers_.size() <= 1) return;
-    for (auto it = servers_.rbegin(); it != servers_.rend(); ++it) {
-        if ((*it)->active() && !(*it)->isBusy(cT_)) {
-            (*it)->setActive(false);
-            return;
+int LoadBalancer::scaleUpClass() const {
+    // the class with the fewest provisioned servers relative to its share
+    int best = 0;
+    for (size_t c = 0; c < classes_.size(); ++c) {
+        if (classes_[c].count <= 0) continue;
+        const ServerClass& b = classes_[static_cast<size_t>(best)];
+        if (b.count <= 0 || static_cast<long long>(classServers_[c]) * b.count <
+                                static_cast<long long>(classServers_[static_cast<size_t>(best)]) * classes_[c].count)
+            best = static_cast<int>(c);
+    }
+    return best;
+}
+
+long long LoadBalancer::capacityOf(const WebServer& s) const {
+    return std::llround(s.slots() * s.speed() * 1000);
+}
+
+void LoadBalancer::provisionServer(int warmup, int cls) {
+    const ServerClass& sc = classes_[static_cast<size_t>(cls)];
+    classServers_[static_cast<size_t>(cls)]++;
+    // a draining server is already warm: keep it rather than bring up another
+    long d = -1;
+    for (long i = draining_.first(); i >= 0; i = draining_.next(static_cast<size_t>(i) + 1))
+        if (servers_[static_cast<size_t>(i)]->serverClass() == cls) d = i;
+    if (d >= 0) {
+        draining_.erase(static_cast<size_t>(d));
+        capacityMilli_ += capacityOf(*servers_[static_cast<size_t>(d)]);
+        activateServer(static_cast<size_t>(d));
+        return;
+    }
+    long f = free_.first();
+    while (f >= 0 && servers_[static_cast<size_t>(f)]->serverClass() != cls) f = free_.next(static_cast<size_t>(f) + 1);
+    size_t sid;
+    if (f >= 0) {
+        sid = static_cast<size_t>(f);
+        free_.erase(sid);
+    } else {
+        sid = servers_.size();
+        servers_.push_back(std::make_unique<WebServer>(static_cast<int>(sid) + 1, cT_, sc.slots, sc.speed, cls));
+        servers_.back()->setState(WebServer::State::Inactive, cT_);
+        idle_.resize(servers_.size());
+        for (ServerSet& set : idleByClass_) set.resize(servers_.size());
+        free_.resize(servers_.size());
+        draining_.resize(servers_.size());
+        if (policy_->usesServerQueues()) serverQ_.resize(servers_.size());
+    }
+    capacityMilli_ += capacityOf(*servers_[sid]);
+    if (warmup > 0) {
+        servers_[sid]->setState(WebServer::State::WarmingUp, cT_);
+        warming_.push_back({cT_ + warmup, sid});
+        return;
+    }
+    activateServer(sid);
+}
+
+void LoadBalancer::activateServer(size_t sid) {
+    WebServer* s = servers_[sid].get();
+    s->setState(WebServer::State::Active, cT_);
+    freeSlots_ += static_cast<size_t>(s->freeSlots());
+    if (s->hasFreeSlot()) setIdle(sid, true);
+    activeCount_++;
+    policy_->serverAdded(sid, *s, cT_);
+    routeBlocked_ = false;
+}
+
+void LoadBalancer::retireServer(size_t sid) {
+    servers_[sid]->setState(WebServer::State::Inactive, cT_);
+    free_.insert(sid);
+}
+
+void LoadBalancer::setIdle(size_t sid, bool idle) {
+    ServerSet& byClass = idleByClass_[static_cast<size_t>(servers_[sid]->serverClass())];
+    if (idle) {
+        idle_.insert(sid);
+        byClass.insert(sid);
+    } else {
+        idle_.erase(sid);
+        byClass.erase(sid);
+    }
+}
+
+void LoadBalancer::activateWarmedUp() {
+    while (!warming_.empty() && warming_.front().first <= cT_) {
+        size_t sid = warming_.front().second;
+        warming_.pop_front();
+        activateServer(sid);
+        logEvent("INFO", "Server " + std::to_string(servers_[sid]->getId()) + " warmed up");
+    }
+}
+
+bool LoadBalancer::removeServer() {
+    if (provisionedCount() <= 1) return false;
+    size_t sid;
+    if (!warming_.empty()) {
+        // newest warming server: it has done no work yet
+        sid = warming_.back().second;
+        warming_.pop_back();
+        retireServer(sid);
+    } else {
+        // highest-numbered server with nothing running
+        long pick = -1;
+        for (long i = idle_.first(); i >= 0; i = idle_.next(static_cast<size_t>(i) + 1))
+            if (servers_[static_cast<size_t>(i)]->busySlots() == 0) pick = i;
+        if (pick >= 0) {
+            sid = static_cast<size_t>(pick);
+            freeSlots_ -= static_cast<size_t>(servers_[sid]->slots());
+            setIdle(sid, false);
+            retireServer(sid);
+        } else {
+            // every server is busy: the one with the least queued, then running, then the
+            // earliest finish, drains
+            size_t bestQueued = 0;
+            for (size_t i = servers_.size(); i-- > 0;) {
+                const WebServer& s = *servers_[i];
+                if (s.state() != WebServer::State::Active) continue;
+                size_t queued = serverQ_.empty() ? 0 : serverQ_[i].size();
+                if (pick >= 0) {
+                    const WebServer& p = *servers_[static_cast<size_t>(pick)];
+                    if (queued > bestQueued) continue;
+                    if (queued == bestQueued && (s.busySlots() > p.busySlots() ||
+                                                 (s.busySlots() == p.busySlots() && s.busyUntil() >= p.busyUntil())))
+                        continue;
+                }
+                pick = static_cast<long>(i);
+                bestQueued = queued;
+            }
+            if (pick < 0) return false;
+            sid = static_cast<size_t>(pick);
+            freeSlots_ -= static_cast<size_t>(servers_[sid]->freeSlots());
+            setIdle(sid, false);
+            servers_[sid]->setState(WebServer::State::Draining, cT_);
+            draining_.insert(sid);
         }
+        activeCount_--;
+        policy_->serverRemoved(sid);
     }
+    classServers_[static_cast<size_t>(servers_[sid]->serverClass())]--;
+    capacityMilli_ -= capacityOf(*servers_[sid]);
+    return true;
 }
 
 void LoadBalancer::setLogStream(std::ostream* os) { logStream_ = os; }
@@ -52,198 +237,814 @@ void LoadBalancer::setLogStream(std::ostream* os) { logStream_ = os; }
 
 
 void LoadBalancer::setLogFile(const std::string& path) {
-    logFile_.open(path);
-    if (logFile_) logEvent("INFO", "Log file opened: " + path);
+    LogLevel level = LogLevel::All;
+    parseLogLevel(cfg_.logLevel, level);
+    LogEncoding encoding = LogEncoding::Text;
+    parseLogEncoding(cfg_.logFormat, encoding);
+    if (log_.open(path, level, encoding)) logEvent("INFO", "Log file opened: " + path);
 }
 
 
 
-void LoadBalancer::generateInitialQueue(std::mt19937& rng) {
-    std::uniform_int_distribution<int> svc(cfg_.minServiceTime, cfg_.maxServiceTime);
-    std::uniform_int_distribution<int> type(0, 1);
-    for (int i = 0; i < cfg_.initialQueueSize; ++i) {
-        Request r(randomIp(rng), randomIp(rng), svc(rng), type(rng) ? 'S' : 'P', 0, nextRequestId_++);
-        if (ipBlocker_.isBlocked(r.ipIn)) {
-            totalBlocked_++;
-            continue;
+bool LoadBalancer::openTrace(const std::string& path) {
+    trace_ = std::make_unique<TraceReader>();
+    return trace_->open(path);
+}
+
+void LoadBalancer::generateInitialQueue() {
+    if (trace_) {
+        replayArrivals(0, false);
+        return;
+    }
+    rQ_.reserve(static_cast<size_t>(std::max(cfg_.initialQueueSize, 0)));
+    generateArrivals(cfg_.initialQueueSize, false);
+}
+
+void LoadBalancer::generateArrivals(int count, bool logDrops) {
+    if (count <= 0) return;
+    workload_.generate(static_cast<uint64_t>(nextRequestId_), static_cast<size_t>(count), blocker(), arrivals_,
+                       [&](const Workload::Batch& b) {
+        for (size_t i = 0; i < b.size(); ++i) {
+            int id = nextRequestId_++;
+            if (b.isBlocked(i)) {
+                totalBlocked_++;
+                if (logDrops) log_.blocked(cT_, b.ipIn[i]);
+                continue;
+            }
+            admit(Request(b.ipIn[i], b.ipOut[i], b.serviceTime[i], b.jobType[i], cT_, id), logDrops);
+        }
+    });
+}
+
+void LoadBalancer::admit(const Request& r, bool logDrops) {
+    // shed arrivals still count as offered load, for the stats and the predictive scaler
+    totGenerated_++;
+    windowArrivals_++;
+    windowWork_ += r.serviceTime;
+    if (admission_.enabled()) {
+        int now = r.arrivalTime;
+        if (admission_.timeout() > 0) expireWaiting(now, logDrops);
+        RequestHandle oldest = kNoRequest;
+        int age = peekOldestWaiting(oldest) ? now - pool_.get(oldest).arrivalTime : 0;
+        switch (admission_.admit(static_cast<uint64_t>(r.id), queuedCount(), age)) {
+        case AdmissionControl::Verdict::Admit:
+            break;
+        case AdmissionControl::Verdict::DropOldest:
+            if (oldest == kNoRequest) {
+                shed(r, ShedReason::QueueFull, now, logDrops);
+                return;
+            }
+            dropOldestWaiting(ShedReason::DropOldest, now, logDrops);
+            break;
+        case AdmissionControl::Verdict::QueueFull:
+            shed(r, ShedReason::QueueFull, now, logDrops);
+            return;
+        case AdmissionControl::Verdict::EarlyDrop:
+            shed(r, ShedReason::EarlyDrop, now, logDrops);
+            return;
         }
-        rQ_.enqueue(r);
-        totGenerated_++;
     }
+    rQ_.enqueue(pool_.acquire(r));
+}
+
+void LoadBalancer::shed(const Request& r, ShedReason why, int now, bool logDrops) {
+    totRejected_++;
+    shed_[static_cast<size_t>(why)]++;
+    int waited = now - r.arrivalTime;
+    if (why == ShedReason::DropOldest || why == ShedReason::Timeout) shedWaitHist_.record(waited);
+    if (logDrops) log_.shed(now, r.id, static_cast<uint8_t>(why), waited);
+}
+
+void LoadBalancer::expireWaiting(int now, bool logDrops) {
+    RequestHandle h;
+    while (peekOldestWaiting(h) && now - pool_.get(h).arrivalTime > admission_.timeout())
+        dropOldestWaiting(ShedReason::Timeout, now, logDrops);
+}
+
+bool LoadBalancer::peekOldestWaiting(RequestHandle& h) const {
+    // reqs are routed in arrival order, so one in a server queue is older than any still central
+    if (!routed_.empty()) return serverQ_[routed_.front().second].peek(h);
+    return rQ_.peekOldest(h);
+}
+
+void LoadBalancer::dropOldestWaiting(ShedReason why, int now, bool logDrops) {
+    RequestHandle h;
+    if (!routed_.empty()) {
+        size_t sid = routed_.front().second;
+        serverQ_[sid].try_dequeue(h);
+        serverQueued_--;
+        routed_.pop_front();
+        pruneRouted();
+        policy_->requestDropped(sid, pool_.get(h));
+        routeBlocked_ = false;  // the policy may take the next req now
+    } else {
+        rQ_.removeOldest(h);
+    }
+    shed(pool_.get(h), why, now, logDrops);
+    pool_.release(h);
+}
+
+void LoadBalancer::pruneRouted() {
+    // the front entry is live while its req still heads that server's queue
+    RequestHandle h;
+    while (!routed_.empty() && !(serverQ_[routed_.front().second].peek(h) && pool_.get(h).id == routed_.front().first))
+        routed_.pop_front();
 }
 
 void LoadBalancer::runSimulation() {
     std::random_device rd;
     unsigned int seed = cfg_.seed != 0 ? cfg_.seed : static_cast<unsigned int>(rd());  // if seed is not set, use a random seed
-    std::mt19937 rng(seed);
-    generateInitialQueue(rng);
+    workload_.seed(seed);
+    admission_.seed(seed);
+    policy_->seed(seed);
+    generateInitialQueue();
 
     initialQueueSize_ = rQ_.size();
 
-    if (logFile_.is_open()) {
-        logFile_ << "Run: " << cfg_.initialServers << " servers, runTime: " << cfg_.runTime << "\n";
-        logFile_ << "Starting queue size: " << rQ_.size() << "\n";
-        logFile_ << "Task time range: [" << cfg_.minServiceTime << ", " << cfg_.maxServiceTime << "]\n";
-        logFile_ << "Seed: " << seed << "\n";
-        logFile_ << "ScaleCooldown: " << cfg_.scaleCooldown << "\n";
-        logFile_ << "LowFactor: " << cfg_.lowFactor << " HighFactor: " << cfg_.highFactor << "\n";
-        logFile_ << "IPRangesBlocked: [";
-        for (size_t i = 0; i < ipBlocker_.getBlockedRanges().size(); ++i) {
-            if (i) logFile_ << ", ";
-            logFile_ << ipBlocker_.getBlockedRanges()[i];
-        }
-        logFile_ << "]\n---\n";
-        logFile_.flush();
-    }
+    writeHeader(seed);
 
     size_t startQueueSize = rQ_.size();
     pQS_ = startQueueSize;
     pQC_ = 0;
 
-    for (cT_ = 0; cT_ < cfg_.runTime; ++cT_) {
-        maybeGenerateNewRequests(rng);
-        sumQueueSize_ += rQ_.size();
-        if (rQ_.size() > pQS_) {
-            pQS_ = rQ_.size();
-            pQC_ = cT_;
+    if (cfg_.engine == "event")
+        runEventLoop();
+    else
+        runCycleLoop();
+    writeSummary();
+    log_.close();
+}
+
+void LoadBalancer::writeHeader(unsigned int seed) {
+    if (!log_.isOpen()) return;
+    std::ostringstream meta;
+    meta << "initialServers=" << cfg_.initialServers << "\nrunTime=" << cfg_.runTime
+         << "\nscaleCooldown=" << cfg_.scaleCooldown << "\ninitialQueueSize=" << cfg_.initialQueueSize
+         << "\nlowFactor=" << cfg_.lowFactor << "\nhighFactor=" << cfg_.highFactor
+         << "\nmaxServers=" << cfg_.maxServers << "\nminServiceTime=" << cfg_.minServiceTime
+         << "\nmaxServiceTime=" << cfg_.maxServiceTime
+         << "\nnewRequestProbabilityPercent=" << cfg_.newRequestProbabilityPercent
+         << "\nengine=" << cfg_.engine << "\nseed=" << seed << "\n";
+    if (trace_) meta << "traceFile=" << cfg_.traceFile << "\n";
+    if (rQ_.discipline() != QueueDiscipline::Fifo) meta << "queueDiscipline=" << cfg_.queueDiscipline << "\n";
+    if (admission_.enabled())
+        meta << "maxQueueDepth=" << cfg_.maxQueueDepth << "\nadmissionPolicy=" << cfg_.admissionPolicy
+             << "\nqueueTimeout=" << cfg_.queueTimeout << "\n";
+    if (!workload_.isDefault())
+        meta << "arrivalProcess=" << cfg_.arrivalProcess << "\narrivalRate=" << cfg_.arrivalRate
+             << "\nserviceDistribution=" << cfg_.serviceDistribution << "\n";
+    if (!cfg_.serverClasses.empty()) {
+        meta << "serverClasses=";
+        for (size_t i = 0; i < cfg_.serverClasses.size(); ++i) meta << (i ? "," : "") << cfg_.serverClasses[i];
+        meta << "\n";
+    }
+    log_.config(meta.str());
+    std::ostringstream os;
+    os << "Run: " << cfg_.initialServers << " servers, runTime: " << cfg_.runTime << "\n";
+    os << "Starting queue size: " << rQ_.size() << "\n";
+    os << "Task time range: [" << cfg_.minServiceTime << ", " << cfg_.maxServiceTime << "]\n";
+    os << "Seed: " << seed << "\n";
+    os << "ScaleCooldown: " << cfg_.scaleCooldown << "\n";
+    os << "LowFactor: " << cfg_.lowFactor << " HighFactor: " << cfg_.highFactor << "\n";
+    os << "IPRangesBlocked: [";
+    for (size_t i = 0; i < blocker().getBlockedRanges().size(); ++i) {
+        if (i) os << ", ";
+        os << blocker().getBlockedRanges()[i];
+    }
+    os << "]\n";
+    if (!blocker().getAllowedRanges().empty()) {
+        os << "IPRangesAllowed: [";
+        for (size_t i = 0; i < blocker().getAllowedRanges().size(); ++i) {
+            if (i) os << ", ";
+            os << blocker().getAllowedRanges()[i];
         }
+        os << "]\n";
+    }
+    if (!cfg_.serverClasses.empty()) {
+        os << "ServerClasses: [";
+        for (size_t c = 0; c < classes_.size(); ++c)
+            os << (c ? ", " : "") << classes_[c].name << " x" << classes_[c].count << " (" << classes_[c].slots
+               << " slots, speed " << classes_[c].speed << ")";
+        os << "]\n";
+    }
+    if (!workload_.isDefault() && !trace_) os << "Workload: " << workload_.describe() << "\n";
+    if (trace_) os << "Trace: " << cfg_.traceFile << (trace_->binary() ? " (binary)" : " (JSONL)") << "\n";
+    if (rQ_.discipline() != QueueDiscipline::Fifo) os << "Queue discipline: " << rQ_.describe() << "\n";
+    if (admission_.enabled()) os << "Admission: " << admission_.describe() << "\n";
+    if (!cfg_.blocklistFile.empty())
+        os << "BlocklistFile: " << cfg_.blocklistFile << " (" << blocker().ruleCount() << " rules)\n";
+    if (predictive_)
+        os << "Scaler: predictive, target utilization " << cfg_.scaleTargetUtilization << "%, plan every "
+           << planPeriod() << " cycles, smoothing " << cfg_.scaleSmoothingPercent << "%, drain "
+           << cfg_.scaleDrainCycles << " cycles, provision delay " << cfg_.provisionDelay << " cycles\n";
+    if (cfg_.realtime)
+        os << "Realtime: " << cfg_.initialServers << " worker threads, " << std::max(cfg_.producers, 1)
+           << " producer threads, workPerUnit: " << cfg_.workPerUnit << "\n";
+    os << "---\n";
+    log_.text(os.str());
+}
+
+int LoadBalancer::nextArrival(int from) {
+    return trace_ ? nextTraceArrival() : workload_.nextArrival(from);
+}
+
+int LoadBalancer::arrive() {
+    if (trace_) replayArrivals(cT_, true);
+    else generateArrivals(workload_.arrivals(), true);
+    return nextArrival(cT_ + 1);
+}
+
+void LoadBalancer::runCycleLoop() {
+    // arrivals are drawn ahead the same way as in the event loop, so both engines
+    // see the same arrivals
+    int nextArrival = this->nextArrival(0);
+    for (int t = 0; t < cfg_.runTime; ++t) {
+        cT_ = t;
+        if (t == nextArrival) nextArrival = arrive();
+        runOneCycleAt(t);
+    }
+}
+
+void LoadBalancer::runEventLoop() {
+    int nextArrival = this->nextArrival(0);
+    int t = 0;
+    while (t < cfg_.runTime) {
+        cT_ = t;
+        skipTo(t);
+        if (t == nextArrival) nextArrival = arrive();
+        runOneCycleAt(t);
+        t = std::min(nextArrival, nextEventTime());
+    }
+    skipTo(cfg_.runTime);
+}
+
+void LoadBalancer::runRealtime() {
+    std::random_device rd;
+    unsigned int seed = cfg_.seed != 0 ? cfg_.seed : static_cast<unsigned int>(rd());
+    workload_.seed(seed);
+    admission_.seed(seed);
+    generateInitialQueue();
+    initialQueueSize_ = rQ_.size();
+    writeHeader(seed);
 
-        for (auto& s : servers_) {
-            if (!s->active()) continue;
-            if (s->isBusy(cT_)) continue;
-            const Request* req = s->currentRequest();
-            if (req) {
-                totCompleted_++;
-                if (logFile_.is_open())
-                    logFile_ << "[" << std::setw(7) << std::setfill('0') << cT_ << "] COMPLETE server=" << s->getId() << " reqID=" << req->id << " queue=" << rQ_.size() << "\n";
-                s->markCompleted();
+    int workers = activeServerCount();
+    int producers = std::max(cfg_.producers, 1);
+    ConcurrentRequestQueue queue(std::max(static_cast<size_t>(std::max(cfg_.realtimeQueueCapacity, 1)), initialQueueSize_));
+    RequestHandle h;
+    while (rQ_.try_dequeue(h)) {
+        queue.try_enqueue(pool_.get(h));
+        pool_.release(h);
+    }
+    pQS_ = initialQueueSize_;
+    pQC_ = 0;
+    logEvent("INFO", "Realtime: " + std::to_string(workers) + " workers, " + std::to_string(producers) + " producers");
+
+    std::vector<WorkerStats> wStats(static_cast<size_t>(workers));
+    std::vector<ProducerStats> pStats(static_cast<size_t>(producers));
+    std::atomic<int> producersLeft{producers};
+    std::atomic<int> workersLeft{workers};
+    int firstId = nextRequestId_;
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            // producer p owns cycles p, p + producers, ... and the id of a req is fixed by its
+            // cycle, so ids stay unique without sharing a counter; draws are counter-based,
+            // so the reqs do not depend on the producer count
+            Workload::Batch one;
+            ProducerStats& st = pStats[static_cast<size_t>(p)];
+            for (int t = p; t < cfg_.runTime; t += producers) {
+                if (!workload_.arrivesAt(t)) continue;
+                workload_.draw(static_cast<uint64_t>(firstId + t), 1, one);
+                if (blocker().isBlocked(one.ipIn[0])) {
+                    st.blocked++;
+                    continue;
+                }
+                Request r(one.ipIn[0], one.ipOut[0], one.serviceTime[0], one.jobType[0], t, firstId + t);
+                while (!queue.try_enqueue(r)) {
+                    st.fullStalls++;
+                    std::this_thread::yield();
+                }
+                st.generated++;
+            }
+            producersLeft.fetch_sub(1, std::memory_order_release);
+        });
+    }
+    for (int w = 0; w < workers; ++w) {
+        threads.emplace_back([&, w] {
+            WorkerStats& st = wStats[static_cast<size_t>(w)];
+            Request r;
+            for (;;) {
+                // read before trying the queue: every enqueue happens before its producer
+                // signs off, so an empty queue after all have signed off stays empty
+                bool producersDone = producersLeft.load(std::memory_order_acquire) == 0;
+                if (queue.try_dequeue(r)) {
+                    auto t0 = std::chrono::steady_clock::now();
+                    st.sink = burnCpu(st.sink + static_cast<uint64_t>(r.id), static_cast<long long>(r.serviceTime) * cfg_.workPerUnit);
+                    st.busyNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+                    st.completed++;
+                } else if (producersDone) {
+                    break;
+                } else {
+                    st.emptyPolls++;
+                    std::this_thread::yield();
+                }
             }
+            workersLeft.fetch_sub(1, std::memory_order_release);
+        });
+    }
+
+    // this thread samples queue depth until the workers drain it
+    while (workersLeft.load(std::memory_order_acquire) > 0) {
+        size_t q = queue.size_approx();
+        sumQueueSize_ += q;
+        if (q > pQS_) {
+            pQS_ = q;
+            pQC_ = static_cast<int>(queueSamples_);
         }
-        distributeRequests();
-        if (cT_ - lST_ >= cfg_.scaleCooldown)
-            scaleIfNeeded();
+        queueSamples_++;
+        std::this_thread::sleep_for(std::chrono::microseconds(kSampleMicros));
+    }
+    for (std::thread& th : threads) th.join();
+    double wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t fullStalls = 0;
+    for (const ProducerStats& st : pStats) {
+        totGenerated_ += st.generated;
+        totalBlocked_ += st.blocked;
+        fullStalls += st.fullStalls;
+    }
+    size_t emptyPolls = 0;
+    size_t minDone = static_cast<size_t>(-1), maxDone = 0;
+    double busySec = 0;
+    for (const WorkerStats& st : wStats) {
+        totCompleted_ += st.completed;
+        emptyPolls += st.emptyPolls;
+        minDone = std::min(minDone, st.completed);
+        maxDone = std::max(maxDone, st.completed);
+        busySec += st.busyNs * 1e-9;
     }
+    nextRequestId_ = firstId + cfg_.runTime;
+
+    std::ostringstream rep;
+    rep << "REALTIME:\n";
+    rep << "Worker threads: " << workers << " Producer threads: " << producers << " Work per service unit: " << cfg_.workPerUnit << "\n";
+    rep << "Wall time: " << std::fixed << std::setprecision(3) << wallSec << " s\n";
+    rep << "Throughput: " << std::setprecision(0) << (wallSec > 0 ? totCompleted_ / wallSec : 0) << " reqs/s\n";
+    realtimeBusy_ = wallSec > 0 ? 100.0 * busySec / (wallSec * workers) : 0;
+    rep << "Worker busy: " << std::setprecision(1) << realtimeBusy_ << "%\n";
+    rep << "Completed per worker: min " << minDone << " max " << maxDone << "\n";
+    rep << "Queue capacity: " << queue.capacity() << " full stalls (producers): " << fullStalls << " empty polls (workers): " << emptyPolls << "\n";
+    rep << "Queue samples: " << queueSamples_ << " (every " << kSampleMicros << " us; pqs cycle is a sample index)\n";
+
     writeSummary();
-    if (logFile_.is_open()) logFile_.close();
+    log_.text(rep.str());
+    log_.close();
+    if (logStream_) *logStream_ << rep.str();
 }
 
 void LoadBalancer::distributeRequests() {
+    if (policy_->usesServerQueues()) {
+        routeRequests();
+        return;
+    }
+    // take exactly as many reqs as there are free slots, oldest first; the fastest class
+    // with a free slot is offered first
+    batch_.resize(std::min(rQ_.size(), freeSlots_));
+    size_t n = rQ_.dequeue_batch(batch_.data(), batch_.size());
+    for (size_t i = 0; i < n; ++i) {
+        const ServerSet* idle = &idle_;
+        if (classes_.size() > 1) {
+            for (int c : classOrder_) {
+                idle = &idleByClass_[static_cast<size_t>(c)];
+                if (!idle->empty()) break;
+            }
+        }
+        startRequest(static_cast<size_t>(policy_->pickIdle(*idle)), batch_[i]);
+    }
+}
 
-    Request req;
-    while (rQ_.try_dequeue(req)) {
-        int sid = nextFreeServerId();
+void LoadBalancer::routeRequests() {
+    // every queued req goes to a server now; it waits in that server's queue if busy
+    RequestHandle h;
+    while (!routeBlocked_ && rQ_.peek(h)) {
+        long sid = policy_->route(pool_.get(h), cT_);
         if (sid < 0) {
-            rQ_.enqueue(req);
+            routeBlocked_ = true;
             break;
         }
-        WebServer* s = servers_[static_cast<size_t>(sid)].get();
-        s->assignRequest(req, cT_);
-        if (logFile_.is_open())
-            logFile_ << "[" << std::setw(7) << std::setfill('0') << cT_ << "] ASSIGN server=" << s->getId() << " reqID=" << req.id << " svc=" << req.serviceTime << " job=" << req.jobType << "\n";
+        rQ_.try_dequeue(h);
+        if (idle_.contains(static_cast<size_t>(sid))) {
+            startRequest(static_cast<size_t>(sid), h);
+        } else {
+            serverQ_[static_cast<size_t>(sid)].enqueue(h);
+            serverQueued_++;
+            if (admission_.enabled()) routed_.push_back({pool_.get(h).id, static_cast<size_t>(sid)});
+        }
     }
 }
 
+void LoadBalancer::startRequest(size_t sid, RequestHandle h) {
+    WebServer* s = servers_[sid].get();
+    const Request& req = pool_.get(h);
+    int slot = s->assignRequest(h, req, cT_);
+    if (s->state() == WebServer::State::Active) {
+        freeSlots_--;
+        if (!s->hasFreeSlot()) setIdle(sid, false);
+    }
+    busy_.push({s->busyUntil(slot), static_cast<int>(sid), slot});
+    int wait = cT_ - req.arrivalTime;
+    size_t type = SchedulingQueue::jobTypeIndex(req.jobType);
+    waitHist_.record(wait);
+    jobWaitHist_[type].record(wait);
+    if (wait > rQ_.deadline(type)) lateStarts_[type]++;
+    log_.assign(cT_, s->getId(), req.id, s->busyUntil(slot) - cT_, req.jobType);
+}
+
 void LoadBalancer::scaleIfNeeded() {
-    int active = activeServerCount();
-    size_t q = rQ_.size();
-    size_t lowThreshold = static_cast<size_t>(cfg_.lowFactor * active);
-    size_t highThreshold = static_cast<size_t>(cfg_.highFactor * active);
+    int active = provisionedCount();
+    size_t q = queuedCount();
+    // thresholds scale with capacity (slots x speed), which is the server count for 1-slot servers
+    size_t lowThreshold = static_cast<size_t>(cfg_.lowFactor * capacityMilli_ / 1000);
+    size_t highThreshold = static_cast<size_t>(cfg_.highFactor * capacityMilli_ / 1000);
 
-    if (q > highThreshold && static_cast<size_t>(servers_.size()) < 100) {
+    if (q > highThreshold && active < cfg_.maxServers) {
         addServer();
         lST_ = cT_;
         scaleUpCount_++;
-        if (logFile_.is_open())
-            logFile_ << "[" << std::setw(7) << std::setfill('0') << cT_ << "] SCALE_UP newServers=" << activeServerCount() << " queueSize=" << q << "\n";
-        logEvent("SCALE_UP", "newServers=" + std::to_string(activeServerCount()) + " queueSize=" + std::to_string(q));
-    
-    
-    } else if (q < lowThreshold && active > 1) {
-        removeServer();
+        log_.scaleUp(cT_, provisionedCount(), q);
+        logEvent("SCALE_UP", "newServers=" + std::to_string(provisionedCount()) + " queueSize=" + std::to_string(q));
+    } else if (q < lowThreshold && active > 1 && removeServer()) {
         lST_ = cT_;
         scaleDownCount_++;
-        if (logFile_.is_open())
-            logFile_ << "[" << std::setw(7) << std::setfill('0') << cT_ << "] SCALE_DOWN newServers=" << activeServerCount() << " queueSize=" << q << "\n";
-        logEvent("SCALE_DOWN", "newServers=" + std::to_string(activeServerCount()) + " queueSize=" + std::to_string(q));
-    }
-}
-
-void LoadBalancer::maybeGenerateNewRequests(std::mt19937& rng) {
-    std::uniform_int_distribution<int> percent(0, 99);
-    std::uniform_int_distribution<int> svc(cfg_.minServiceTime, cfg_.maxServiceTime);
-    std::uniform_int_distribution<int> type(0, 1);
-    if (percent(rng) >= cfg_.newRequestProbabilityPercent) return;
-    Request r(randomIp(rng), randomIp(rng), svc(rng), type(rng) ? 'S' : 'P', cT_, nextRequestId_++);
-    if (ipBlocker_.isBlocked(r.ipIn)) {
-        totalBlocked_++;
-        if (logFile_.is_open())
-            logFile_ << "[" << std::setw(7) << std::setfill('0') << cT_ << "] BLOCKED ip=" << r.ipIn << " reason=blocked-range\n";
+        log_.scaleDown(cT_, provisionedCount(), q);
+        logEvent("SCALE_DOWN", "newServers=" + std::to_string(provisionedCount()) + " queueSize=" + std::to_string(q));
+    }
+}
+
+void LoadBalancer::replayArrivals(int cycle, bool logDrops) {
+    for (const TraceRecord* r = trace_->peek(); r && r->arrival <= cycle; r = trace_->peek()) {
+        int id = nextRequestId_++;
+        if (blocker().isBlocked(r->ipIn)) {
+            totalBlocked_++;
+            if (logDrops) log_.blocked(cycle, r->ipIn);
+        } else {
+            admit(Request(r->ipIn, r->ipOut, r->serviceTime, r->jobType, r->arrival, id), logDrops);
+        }
+        trace_->pop();
+    }
+}
+
+int LoadBalancer::nextTraceArrival() {
+    const TraceRecord* r = trace_->peek();
+    return r && r->arrival < cfg_.runTime ? r->arrival : cfg_.runTime;
+}
+
+void LoadBalancer::planCapacity() {
+    if (lastPlan_ < 0) {
+        // the first plan only opens the window: the initial queue is backlog, not a rate
+        lastPlan_ = cT_;
+        windowArrivals_ = 0;
+        windowWork_ = 0;
         return;
     }
-    rQ_.enqueue(r);
-    totGenerated_++;
+    double alpha = std::min(std::max(cfg_.scaleSmoothingPercent, 1), 100) / 100.0;
+    double rate = static_cast<double>(windowArrivals_) / std::max(cT_ - lastPlan_, 1);
+    rateEwma_ = rateEwma_ < 0 ? rate : rateEwma_ + alpha * (rate - rateEwma_);
+    if (windowArrivals_ > 0) {
+        double svc = static_cast<double>(windowWork_) / static_cast<double>(windowArrivals_);
+        svcEwma_ = svcEwma_ < 0 ? svc : svcEwma_ + alpha * (svc - svcEwma_);
+    }
+    lastPlan_ = cT_;
+    windowArrivals_ = 0;
+    windowWork_ = 0;
+    double svc = svcEwma_ > 0 ? svcEwma_ : (cfg_.minServiceTime + cfg_.maxServiceTime) / 2.0;
+    svc = std::max(svc, 1.0);
+
+    // servers kept busy by arrivals, plus enough to clear the backlog expected once
+    // anything provisioned now is up
+    int active = activeServerCount();
+    int pending = static_cast<int>(warming_.size());
+    int capacity = active + pending;
+    // need is in 1-slot speed-1 servers; the fleet's average converts it to servers
+    double perServer = capacity > 0 ? capacityMilli_ / 1000.0 / capacity : 1.0;
+    double load = rateEwma_ * svc;
+    double queued = static_cast<double>(queuedCount());
+    double projected = std::max(0.0, queued + (rateEwma_ - active * perServer / svc) * std::max(cfg_.provisionDelay, 0));
+    double util = std::min(std::max(cfg_.scaleTargetUtilization, 1), 100) / 100.0;
+    double need = (load + projected * svc / std::max(cfg_.scaleDrainCycles, 1)) / util;
+    int target = std::min(std::max(static_cast<int>(std::ceil(need / perServer)), 1), std::max(cfg_.maxServers, 1));
+
+    int delta = 0;
+    if (target > capacity) {
+        delta = target - capacity;
+    } else {
+        // hysteresis: keep some slack above target so steady load does not flap
+        int keep = target + target * kScaleDownSlackPercent / 100;
+        if (capacity > keep) delta = keep - capacity;
+    }
+    if (cfg_.scaleMaxStep > 0) delta = std::min(std::max(delta, -cfg_.scaleMaxStep), cfg_.scaleMaxStep);
+    if (delta == 0) return;
+
+    int added = 0, cancelled = 0, removed = 0;
+    if (delta > 0) {
+        for (; added < delta; ++added) {
+            addServer();
+            scaleUpCount_++;
+            log_.scaleUp(cT_, provisionedCount(), queuedCount());
+        }
+    } else {
+        // warming servers go first, then idle ones, then busy ones drain
+        while (cancelled + removed < -delta) {
+            bool warming = !warming_.empty();
+            if (!removeServer()) break;
+            if (warming) cancelled++;
+            else removed++;
+            scaleDownCount_++;
+            log_.scaleDown(cT_, provisionedCount(), queuedCount());
+        }
+        if (cancelled + removed == 0) return;
+    }
+    lST_ = cT_;
+
+    std::ostringstream why;
+    why << std::fixed << std::setprecision(3) << "target=" << target << " active=" << active << " pending=" << pending
+        << " ->";
+    if (added) why << " +" << added << (cfg_.provisionDelay > 0 ? " warming" : "");
+    if (cancelled) why << " -" << cancelled << " warming";
+    if (removed) why << " -" << removed;
+    why << " (arrivals " << rateEwma_ << "/cycle x svc " << std::setprecision(1) << svc << " = load "
+        << std::setprecision(2) << load << ", queue " << queuedCount();
+    if (cfg_.provisionDelay > 0) why << " projected " << static_cast<long long>(projected);
+    why << ", util " << util * 100 << "%)";
+    if (log_.wants(LogKind::ScaleUp)) {
+        char stamp[16];
+        std::snprintf(stamp, sizeof(stamp), "[%07d] ", cT_);
+        log_.text(stamp + std::string("SCALE_PLAN ") + why.str() + "\n");
+    }
+    logEvent("SCALE_PLAN", why.str());
 }
 
 void LoadBalancer::enqueueRequest(const Request& r) {
-    rQ_.enqueue(r);
-    totGenerated_++;
+    admit(r, true);
 }
 
 void LoadBalancer::runOneCycleAt(int currentTime) {
+    skipTo(currentTime);
     cT_ = currentTime;
-    sumQueueSize_ += rQ_.size();
-    if (rQ_.size() > pQS_) {
-        pQS_ = rQ_.size();
+    lastCycle_ = currentTime;
+    if (admission_.timeout() > 0) expireWaiting(cT_, true);
+    size_t queued = queuedCount();
+    sumQueueSize_ += queued;
+    if (queued > pQS_) {
+        pQS_ = queued;
         pQC_ = cT_;
     }
-    for (auto& s : servers_) {
-        if (!s->active()) { continue;}
-        if (s->isBusy(cT_)) continue;
-        const Request* req = s->currentRequest();
-        if (req) {
-            totCompleted_++;
-            s->markCompleted();
+    // reqs finishing this cycle, completed in server then slot order like a full scan would
+    done_.clear();
+    while (!busy_.empty() && std::get<0>(busy_.top()) <= cT_) {
+        done_.push_back({std::get<1>(busy_.top()), std::get<2>(busy_.top())});
+        busy_.pop();
+    }
+    std::sort(done_.begin(), done_.end());
+    for (auto [id, slot] : done_) {
+        size_t sid = static_cast<size_t>(id);
+        WebServer* s = servers_[sid].get();
+        RequestHandle h = s->currentRequest(slot);
+        const Request& req = pool_.get(h);
+        totCompleted_++;
+        sojournHist_.record(cT_ - req.arrivalTime);
+        log_.complete(cT_, s->getId(), req.id, queuedCount());
+        s->markCompleted(slot);
+        pool_.release(h);
+        bool active = s->state() == WebServer::State::Active;
+        if (active) {
+            freeSlots_++;
+            setIdle(sid, true);
+        }
+        // a server with its own queue starts the next req right away
+        RequestHandle next;
+        bool more = !serverQ_.empty() && serverQ_[sid].try_dequeue(next);
+        policy_->requestDone(sid, !more);
+        if (more) {
+            serverQueued_--;
+            if (!routed_.empty()) pruneRouted();
+            startRequest(sid, next);
+        } else if (!active) {
+            if (s->busySlots() == 0) {
+                draining_.erase(sid);
+                retireServer(sid);
+            }
+        } else {
+            routeBlocked_ = false;
         }
     }
+    activateWarmedUp();
     distributeRequests();
-    if (cT_ - lST_ >= cfg_.scaleCooldown)
+    if (predictive_) {
+        if (cT_ % planPeriod() == 0) planCapacity();
+    } else if (cT_ - lST_ >= cfg_.scaleCooldown) {
         scaleIfNeeded();
+    }
+    if (metrics_.nextSample() <= cT_) sampleThrough(cT_);
+}
+
+int LoadBalancer::nextEventTime() const {
+    // a freed or newly added server can take queued work on the very next cycle
+    if (!rQ_.empty() && (policy_->usesServerQueues() ? !routeBlocked_ : !idle_.empty())) return cT_ + 1;
+    int next = cfg_.runTime;
+    if (!busy_.empty()) next = std::min(next, std::get<0>(busy_.top()));
+    if (!warming_.empty()) next = std::min(next, warming_.front().first);
+    RequestHandle oldest;
+    if (admission_.timeout() > 0 && peekOldestWaiting(oldest))
+        next = std::min(next, pool_.get(oldest).arrivalTime + admission_.timeout() + 1);
+    if (predictive_) {
+        // plans run on a fixed grid
+        next = std::min(next, (cT_ / planPeriod() + 1) * planPeriod());
+        return std::max(next, cT_ + 1);
+    }
+    // the scale check reruns once the cooldown expires, and right after a scale
+    // event because the active-server count it compares against just changed
+    if (lST_ == cT_)
+        next = std::min(next, std::max(cT_ + 1, lST_ + cfg_.scaleCooldown));
+    else if (lST_ + cfg_.scaleCooldown > cT_)
+        next = std::min(next, lST_ + cfg_.scaleCooldown);
+    return std::max(next, cT_ + 1);
+}
+
+void LoadBalancer::skipTo(int cycle) {
+    long long gap = static_cast<long long>(cycle) - lastCycle_ - 1;
+    if (gap <= 0) return;
+    sumQueueSize_ += queuedCount() * static_cast<size_t>(gap);
+    lastCycle_ = cycle - 1;
+    if (metrics_.nextSample() <= lastCycle_) sampleThrough(lastCycle_);
+}
+
+void LoadBalancer::sampleThrough(int cycle) {
+    // nothing changes between events, so a sample due in a skipped cycle sees the current state
+    while (metrics_.nextSample() <= cycle)
+        metrics_.record(static_cast<int64_t>(queuedCount()), activeCount_, static_cast<int>(busy_.size()),
+                        totGenerated_, totCompleted_, totalBlocked_);
+}
+
+bool LoadBalancer::writeMetrics(const std::string& path) const {
+    MetricsFormat format = MetricsFormat::Csv;
+    parseMetricsFormat(cfg_.metricsFormat, format);
+    return MetricsSeries::writeFile(path, format, {{"lb", &metrics_}});
 }
 
 void LoadBalancer::writeSummaryTo(std::ostream& os, const std::string& namePrefix) const {
     writeSummaryToImpl(os, namePrefix);
 }
 
-size_t LoadBalancer::getQueueSize() const { return rQ_.size(); }
+void LoadBalancer::seed(unsigned int seed) {
+    admission_.seed(seed);
+    policy_->seed(seed);
+}
+
+void LoadBalancer::markStartingQueue() { initialQueueSize_ = queuedCount(); }
+
+size_t LoadBalancer::getQueueSize() const { return queuedCount(); }
 size_t LoadBalancer::getTotalCompleted() const { return totCompleted_; }
 size_t LoadBalancer::getTotalGenerated() const { return totGenerated_; }
 
+LoadBalancer::Metrics LoadBalancer::getMetrics() const {
+    Metrics m;
+    m.generated = totGenerated_;
+    m.completed = totCompleted_;
+    m.blocked = totalBlocked_;
+    m.rejected = totRejected_;
+    m.shed = shed_;
+    m.endQueue = queuedCount();
+    m.peakQueue = pQS_;
+    m.peakQueueCycle = pQC_;
+    // real-time runs have no cycles; their queue depth is sampled instead
+    size_t samples = queueSamples_ > 0 ? queueSamples_ : static_cast<size_t>(std::max(cfg_.runTime, 0));
+    m.avgQueue = samples > 0 ? static_cast<double>(sumQueueSize_) / samples : 0;
+    m.activeServers = activeServerCount();
+    int end = std::max(cfg_.runTime, 0);
+    for (size_t c = 0; c < classes_.size(); ++c) {
+        Metrics::Class mc;
+        mc.name = classes_[c].name;
+        mc.slots = classes_[c].slots;
+        mc.speed = classes_[c].speed;
+        mc.servers = classServers_[c];
+        m.classes.push_back(mc);
+    }
+    long long upCycles = 0;  // server-cycles, whatever the slot count
+    for (const auto& sv : servers_) {
+        WebServer::CycleCounts c = sv->cycleCounts(end);
+        long long provisioned = c.busy + c.idle + c.warming;
+        m.serverCycles += provisioned;
+        m.busyCycles += c.busy;
+        m.warmingCycles += c.warming;
+        upCycles += provisioned / sv->slots();
+        Metrics::Class& mc = m.classes[static_cast<size_t>(sv->serverClass())];
+        mc.slotCycles += provisioned;
+        mc.busyCycles += c.busy;
+    }
+    m.serverSlots = static_cast<int>(servers_.size());
+    m.avgActiveServers = end > 0 ? static_cast<double>(upCycles) / end : 0;
+    if (queueSamples_ > 0) m.utilization = realtimeBusy_;
+    else m.utilization = m.serverCycles > 0 ? 100.0 * m.busyCycles / m.serverCycles : 0;
+    m.scaleUps = scaleUpCount_;
+    m.scaleDowns = scaleDownCount_;
+    m.waitP99 = waitHist_.percentile(99);
+    return m;
+}
+
 void LoadBalancer::writeSummaryToImpl(std::ostream& os, const std::string& namePrefix) const {
+    Metrics m = getMetrics();
     if (!namePrefix.empty()) os << "---\n" << namePrefix << " LOAD BALANCER\n---\n";
     else os << "SUMMARY:\n";
-    os << "End queue size: " << rQ_.size() << "\n";
-    os << "Total # generated: " << totGenerated_ << "\n";
-    os << "Total # completed: " << totCompleted_ << "\n";
-    os << "Total # blocked: " << totalBlocked_ << "\n";
-    os << "Total # rejected/discarded: " << totRejected_ << "\n";
+    os << "End queue size: " << m.endQueue << "\n";
+    os << "Total # generated: " << m.generated << "\n";
+    os << "Total # completed: " << m.completed << "\n";
+    os << "Total # blocked: " << m.blocked << "\n";
+    os << "Total # rejected/discarded: " << m.rejected << "\n";
+    if (admission_.enabled()) {
+        os << "Shed:";
+        for (size_t i = 0; i < kShedReasons; ++i)
+            os << (i ? "," : "") << " " << shedReasonName(static_cast<ShedReason>(i)) << " " << m.shed[i];
+        os << " (" << std::fixed << std::setprecision(1)
+           << (m.generated > 0 ? 100.0 * m.rejected / m.generated : 0) << "% of generated)\n";
+        if (shedWaitHist_.count() > 0) {
+            os << "Waited before discard (cycles): ";
+            shedWaitHist_.writeTo(os);
+            os << "\n";
+        }
+    }
     os << "Starting queue size: " << initialQueueSize_ << "\n";
-    int active = activeServerCount();
-    os << "Active servers (final): " << active << "\n";
-    os << "Inactive servers (scaled down): " << (static_cast<int>(servers_.size()) - active) << "\n";
-    os << "Peak queue size (pqs): " << pQS_ << " at cycle " << pQC_ << "\n";
-    double avgQueue = cfg_.runTime > 0 ? static_cast<double>(sumQueueSize_) / cfg_.runTime : 0;
-    os << "Avg queue size (aqs): " << std::fixed << std::setprecision(1) << avgQueue << "\n";
-    double utilization = (cfg_.runTime > 0 && active > 0)
-        ? (100.0 * totCompleted_ / (cfg_.runTime * static_cast<double>(active))) : 0;
-    os << "Avg server utilization: " << std::fixed << std::setprecision(1) << utilization << "%\n";
-    os << "Scale-up events: " << scaleUpCount_ << " Scale-down events: " << scaleDownCount_ << "\n";
+    os << "Active servers (final): " << m.activeServers << "\n";
+    os << "Inactive servers (scaled down): " << free_.size() << " of " << m.serverSlots << " slots\n";
+    if (!warming_.empty() || !draining_.empty())
+        os << "Warming servers (final): " << warming_.size() << " Draining servers (final): " << draining_.size() << "\n";
+    os << "Peak queue size (pqs): " << m.peakQueue << " at cycle " << m.peakQueueCycle << "\n";
+    os << "Avg queue size (aqs): " << std::fixed << std::setprecision(1) << m.avgQueue << "\n";
+    os << "Avg server utilization: " << std::fixed << std::setprecision(1) << m.utilization << "%\n";
+    if (queueSamples_ == 0) {
+        bool multiSlot = false;
+        for (const ServerClass& c : classes_) multiSlot = multiSlot || c.slots > 1;
+        os << (multiSlot ? "Slot-cycles" : "Server-cycles") << " provisioned: " << m.serverCycles << " (avg active servers: " << m.avgActiveServers
+           << ") busy: " << m.busyCycles << " idle: " << (m.serverCycles - m.busyCycles - m.warmingCycles);
+        if (m.warmingCycles > 0) os << " warming: " << m.warmingCycles;
+        os << "\n";
+        // spread over every server that was ever active, each against its own active cycles
+        std::vector<double> perServer;
+        for (const auto& sv : servers_) {
+            WebServer::CycleCounts c = sv->cycleCounts(std::max(cfg_.runTime, 0));
+            long long up = c.busy + c.idle + c.warming;
+            if (up > 0) perServer.push_back(100.0 * c.busy / up);
+        }
+        if (!perServer.empty()) {
+            std::sort(perServer.begin(), perServer.end());
+            auto at = [&](double q) { return perServer[static_cast<size_t>(q * (perServer.size() - 1) + 0.5)]; };
+            os << "Per-server utilization: min " << perServer.front() << "% p50 " << at(0.5) << "% p90 " << at(0.9)
+               << "% max " << perServer.back() << "% (" << perServer.size() << " servers)\n";
+        }
+        if (!cfg_.serverClasses.empty()) {
+            for (const Metrics::Class& c : m.classes)
+                os << "Class " << c.name << " (" << c.slots << " slots, speed " << std::setprecision(2) << c.speed
+                   << "): " << c.servers << " servers, utilization " << std::setprecision(1)
+                   << (c.slotCycles > 0 ? 100.0 * c.busyCycles / c.slotCycles : 0) << "% (busy " << c.busyCycles
+                   << " of " << c.slotCycles << " slot-cycles)\n";
+        }
+    }
+    os << "Scale-up events: " << m.scaleUps << " Scale-down events: " << m.scaleDowns << "\n";
+    if (waitHist_.count() > 0) {
+        os << "Wait time (cycles): ";
+        waitHist_.writeTo(os);
+        os << "\nSojourn time (cycles): ";
+        sojournHist_.writeTo(os);
+        os << "\n";
+        const char* types[SchedulingQueue::kJobTypes] = {"S", "P"};
+        if (rQ_.discipline() != QueueDiscipline::Fifo) {
+            for (size_t t = 0; t < SchedulingQueue::kJobTypes; ++t) {
+                os << "Wait time " << types[t] << " (cycles): ";
+                jobWaitHist_[t].writeTo(os);
+                os << "\n";
+            }
+        }
+        if (rQ_.discipline() == QueueDiscipline::Edf) {
+            os << "Deadline misses (started late):";
+            for (size_t t = 0; t < SchedulingQueue::kJobTypes; ++t) {
+                uint64_t n = jobWaitHist_[t].count();
+                os << (t ? ", " : " ") << types[t] << " " << lateStarts_[t] << " of " << n << " ("
+                   << std::setprecision(1) << (n > 0 ? 100.0 * lateStarts_[t] / n : 0) << "%)";
+            }
+            os << "\n";
+        }
+    }
     os << "RunTime (rt): " << cfg_.runTime << " cycles\n";
     os << "Task / service time range: [" << cfg_.minServiceTime << ", " << cfg_.maxServiceTime << "]\n";
 }
 
 void LoadBalancer::writeSummary() {
-    if (!logFile_.is_open()) return;
-    writeSummaryToImpl(logFile_, "");
+    if (!log_.isOpen()) return;
+    std::ostringstream os;
+    writeSummaryToImpl(os, "");
+    log_.text(os.str());
 }
 
 void LoadBalancer::logEvent(const std::string& kind, const std::string& msg) {
@@ -258,19 +1059,5 @@ void LoadBalancer::logEvent(const std::string& kind, const std::string& msg) {
 }
 
 int LoadBalancer::activeServerCount() const {
-    int n = 0;
-    for (const auto& s : servers_) {
-        if (s->active()) {
-            n++;
-        }
-    }
-    return n;
-}
-
-int LoadBalancer::nextFreeServerId() const {
-    for (size_t i = 0; i < servers_.size(); ++i) {
-        if (servers_[i]->active() && !servers_[i]->isBusy(cT_))
-            return static_cast<int>(i);
-    }
-    return -1;
+    return activeCount_;
 }
@@ -0,0 +1,331 @@
+/**
+ * @file LogAnalyzer.cpp
+ * @brief Implementation of LogAnalyzer: mmap, chunked parallel parse, report.
+ */
+
+#include "LogAnalyzer.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <thread>
+
+#ifdef _WIN32
+#define LB_NO_MMAP
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr size_t kMinChunkBytes = 1 << 20;  /**< smaller logs are not worth another thread */
+
+/** Read-only view of a whole file: mmap where available, else a copy in memory */
+class MappedFile {
+public:
+    ~MappedFile() {
+#ifndef LB_NO_MMAP
+        if (map_) munmap(map_, size_);
+#endif
+    }
+
+    bool open(const std::string& path) {
+#ifdef LB_NO_MMAP
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return false;
+        copy_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        data_ = copy_.data();
+        size_ = copy_.size();
+        return true;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ > 0) {
+            map_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map_ == MAP_FAILED) {
+                map_ = nullptr;
+                ::close(fd);
+                return false;
+            }
+            madvise(map_, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(map_);
+        }
+        ::close(fd);
+        return true;
+#endif
+    }
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_{""};
+    size_t size_{0};
+#ifdef LB_NO_MMAP
+    std::string copy_;
+#else
+    void* map_{nullptr};
+#endif
+};
+
+bool literal(const char*& p, const char* e, const char* lit) {
+    size_t n = std::strlen(lit);
+    if (static_cast<size_t>(e - p) < n || std::memcmp(p, lit, n) != 0) return false;
+    p += n;
+    return true;
+}
+
+bool number(const char*& p, const char* e, int64_t& v) {
+    bool neg = p < e && *p == '-';
+    if (neg) ++p;
+    const char* start = p;
+    v = 0;
+    for (; p < e && *p >= '0' && *p <= '9'; ++p) v = v * 10 + (*p - '0');
+    if (neg) v = -v;
+    return p != start;
+}
+
+/** Parse one "[0000123] KIND key=value ..." line (p..e, no newline) */
+bool parseEventLine(const char* p, const char* e, LogRecord& r) {
+    int64_t cycle, a, b, c;
+    ++p;  // '['
+    if (!number(p, e, cycle) || !literal(p, e, "] ")) return false;
+    r = LogRecord{static_cast<int32_t>(cycle), LogKind::Text, 0, 0, 0, 0};
+    if (literal(p, e, "ASSIGN server=")) {
+        if (!number(p, e, a) || !literal(p, e, " reqID=") || !number(p, e, b) || !literal(p, e, " svc=")
+            || !number(p, e, c) || !literal(p, e, " job=") || p == e)
+            return false;
+        r.kind = LogKind::Assign;
+        r.job = *p;
+    } else if (literal(p, e, "COMPLETE server=")) {
+        if (!number(p, e, a) || !literal(p, e, " reqID=") || !number(p, e, b) || !literal(p, e, " queue=")
+            || !number(p, e, c))
+            return false;
+        r.kind = LogKind::Complete;
+    } else if (literal(p, e, "SCALE_")) {
+        if (literal(p, e, "UP")) r.kind = LogKind::ScaleUp;
+        else if (literal(p, e, "DOWN")) r.kind = LogKind::ScaleDown;
+        else return literal(p, e, "PLAN ");  // predictive scaler decision: a note, no stats
+        b = 0;
+        if (!literal(p, e, " newServers=") || !number(p, e, a) || !literal(p, e, " queueSize=") || !number(p, e, c))
+            return false;
+    } else if (literal(p, e, "BLOCKED ")) {
+        r.kind = LogKind::Blocked;
+        return true;
+    } else if (literal(p, e, "SHED ")) {
+        r.kind = LogKind::Shed;
+        return true;
+    } else {
+        return false;
+    }
+    r.a = static_cast<int32_t>(a);
+    r.b = static_cast<int32_t>(b);
+    r.c = c;
+    return true;
+}
+
+void parseChunk(const char* p, const char* end, LogStats& s) {
+    s.bytes = static_cast<uint64_t>(end - p);
+    while (p < end) {
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        const char* e = nl ? nl : end;
+        if (e > p && e[-1] == '\r') --e;
+        ++s.lines;
+        // header and summary lines are free text; only "[cycle]" lines are events
+        if (p < e && *p == '[') {
+            LogRecord r;
+            if (parseEventLine(p, e, r)) s.add(r);
+            else ++s.malformed;
+        }
+        p = nl ? nl + 1 : end;
+    }
+}
+
+} // namespace
+
+void LogStats::add(const LogRecord& r) {
+    ++events;
+    if (firstCycle < 0) firstCycle = r.cycle;
+    lastCycle = r.cycle;
+    size_t server = static_cast<size_t>(std::max(r.a, 0));
+    switch (r.kind) {
+    case LogKind::Assign:
+        if (server >= servers.size()) servers.resize(server + 1);
+        servers[server].assigned++;
+        servers[server].busy += static_cast<uint64_t>(std::max<int64_t>(r.c, 0));
+        return;
+    case LogKind::Complete:
+        if (server >= servers.size()) servers.resize(server + 1);
+        servers[server].completed++;
+        break;
+    case LogKind::ScaleUp:
+    case LogKind::ScaleDown:
+        scaleEvents.push_back({r.cycle, r.kind == LogKind::ScaleUp, r.a, r.c});
+        break;
+    case LogKind::Blocked:
+        blocked++;
+        return;
+    case LogKind::Shed:
+        shed++;
+        return;
+    case LogKind::Text:
+    case LogKind::Config:
+        --events;
+        return;
+    }
+    size_t depth = static_cast<size_t>(std::max<int64_t>(r.c, 0));
+    if (depth >= queueDepths.size()) queueDepths.resize(std::max(depth + 1, queueDepths.size() * 2));
+    queueDepths[depth]++;
+}
+
+void LogStats::merge(const LogStats& later) {
+    bytes += later.bytes;
+    lines += later.lines;
+    events += later.events;
+    malformed += later.malformed;
+    if (firstCycle < 0) firstCycle = later.firstCycle;
+    if (later.lastCycle >= 0) lastCycle = later.lastCycle;
+    if (later.servers.size() > servers.size()) servers.resize(later.servers.size());
+    for (size_t i = 0; i < later.servers.size(); ++i) {
+        servers[i].assigned += later.servers[i].assigned;
+        servers[i].completed += later.servers[i].completed;
+        servers[i].busy += later.servers[i].busy;
+    }
+    scaleEvents.insert(scaleEvents.end(), later.scaleEvents.begin(), later.scaleEvents.end());
+    if (later.queueDepths.size() > queueDepths.size()) queueDepths.resize(later.queueDepths.size());
+    for (size_t i = 0; i < later.queueDepths.size(); ++i) queueDepths[i] += later.queueDepths[i];
+    blocked += later.blocked;
+    shed += later.shed;
+}
+
+int64_t LogStats::queuePercentile(double q) const {
+    uint64_t total = 0;
+    for (uint64_t n : queueDepths) total += n;
+    if (total == 0) return -1;
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total - 1));
+    uint64_t seen = 0;
+    for (size_t d = 0; d < queueDepths.size(); ++d) {
+        seen += queueDepths[d];
+        if (seen > rank) return static_cast<int64_t>(d);
+    }
+    return static_cast<int64_t>(queueDepths.size()) - 1;
+}
+
+LogAnalyzer::LogAnalyzer(int threads)
+    : threads_(threads > 0 ? threads : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()))) {}
+
+bool LogAnalyzer::analyzeFile(const std::string& path, LogStats& out) {
+    MappedFile file;
+    if (!file.open(path)) return false;
+    out = LogStats();
+    if (file.size() >= sizeof(kBinaryLogMagic)
+        && std::memcmp(file.data(), kBinaryLogMagic, sizeof(kBinaryLogMagic)) == 0)
+        return analyzeBinary(file.data(), file.size(), out);
+    analyzeText(file.data(), file.size(), out);
+    return true;
+}
+
+void LogAnalyzer::analyzeText(const char* data, size_t size, LogStats& out) {
+    size_t chunks = std::min(static_cast<size_t>(threads_), size / kMinChunkBytes + 1);
+    // chunk i covers [bounds[i], bounds[i + 1]), each boundary moved past the next newline
+    std::vector<const char*> bounds(chunks + 1, data + size);
+    bounds[0] = data;
+    for (size_t i = 1; i < chunks; ++i) {
+        const char* p = std::max(bounds[i - 1], data + size / chunks * i);
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(data + size - p)));
+        bounds[i] = nl ? nl + 1 : data + size;
+    }
+    std::vector<LogStats> parts(chunks);
+    std::vector<std::thread> pool;
+    for (size_t i = 1; i < chunks; ++i)
+        pool.emplace_back([&, i] { parseChunk(bounds[i], bounds[i + 1], parts[i]); });
+    parseChunk(bounds[0], bounds[1], parts[0]);
+    for (std::thread& t : pool) t.join();
+    out = std::move(parts[0]);
+    for (size_t i = 1; i < chunks; ++i) out.merge(parts[i]);
+}
+
+bool LogAnalyzer::analyzeBinary(const char* data, size_t size, LogStats& out) {
+    const char* p = data;
+    const char* end = data + size;
+    BinaryLogDecoder decoder;
+    if (!decoder.begin(p, end)) return false;
+    out.bytes = size;
+    LogRecord r;
+    std::string text;
+    const char* record = p;
+    while (decoder.next(p, end, r, text)) {
+        record = p;
+        if (r.kind == LogKind::Text) out.lines += static_cast<uint64_t>(std::count(text.begin(), text.end(), '\n'));
+        else if (r.kind != LogKind::Config) ++out.lines;
+        out.add(r);
+    }
+    return record == end;
+}
+
+void LogAnalyzer::writeReport(const std::string& name, const LogStats& s, double seconds,
+                              bool timeline, std::ostream& os) {
+    os << "== " << name << " ==\n";
+    os << std::fixed << std::setprecision(1);
+    os << "Read " << s.bytes << " bytes, " << s.lines << " lines in " << std::setprecision(3) << seconds
+       << " s (" << std::setprecision(1) << (seconds > 0 ? s.bytes / seconds / 1e6 : 0) << " MB/s)\n";
+    os << "Events: " << s.events << " (malformed lines: " << s.malformed << ")";
+    if (s.firstCycle >= 0) os << " cycles " << s.firstCycle << ".." << s.lastCycle;
+    os << "\n";
+
+    uint64_t assigned = 0, completed = 0;
+    for (const LogStats::Server& sv : s.servers) {
+        assigned += sv.assigned;
+        completed += sv.completed;
+    }
+    os << "Requests: assigned " << assigned << " completed " << completed << " blocked " << s.blocked;
+    if (s.shed > 0) os << " shed " << s.shed;
+    os << "\n";
+
+    double span = s.firstCycle >= 0 ? static_cast<double>(s.lastCycle - s.firstCycle + 1) : 0;
+    os << "Per server (busy = sum of svc assigned, % of the logged span):\n";
+    os << "  server  assigned  completed        busy   busy%\n";
+    for (size_t i = 0; i < s.servers.size(); ++i) {
+        const LogStats::Server& sv = s.servers[i];
+        if (sv.assigned == 0 && sv.completed == 0) continue;
+        os << std::setw(8) << i << std::setw(10) << sv.assigned << std::setw(11) << sv.completed
+           << std::setw(12) << sv.busy << std::setw(7) << (span > 0 ? 100.0 * sv.busy / span : 0) << "%\n";
+    }
+
+    uint64_t samples = 0;
+    for (uint64_t n : s.queueDepths) samples += n;
+    os << "Queue depth (" << samples << " samples at COMPLETE / SCALE lines):";
+    if (samples > 0)
+        os << " p50 " << s.queuePercentile(0.50) << " p90 " << s.queuePercentile(0.90) << " p99 "
+           << s.queuePercentile(0.99) << " max " << s.queuePercentile(1.0);
+    os << "\n";
+
+    size_t ups = 0;
+    int32_t minServers = 0, maxServers = 0;
+    for (size_t i = 0; i < s.scaleEvents.size(); ++i) {
+        const LogStats::ScaleEvent& ev = s.scaleEvents[i];
+        if (ev.up) ++ups;
+        minServers = i == 0 ? ev.servers : std::min(minServers, ev.servers);
+        maxServers = i == 0 ? ev.servers : std::max(maxServers, ev.servers);
+    }
+    os << "Scale events: " << ups << " up, " << s.scaleEvents.size() - ups << " down";
+    if (!s.scaleEvents.empty())
+        os << "; servers after events min " << minServers << " max " << maxServers << " final "
+           << s.scaleEvents.back().servers;
+    os << "\n";
+    if (timeline) {
+        for (const LogStats::ScaleEvent& ev : s.scaleEvents)
+            os << "  [" << std::setw(7) << std::setfill('0') << ev.cycle << std::setfill(' ') << "] "
+               << (ev.up ? "SCALE_UP   " : "SCALE_DOWN ") << "servers=" << ev.servers << " queue=" << ev.queue << "\n";
+    }
+}
@@ -0,0 +1,263 @@
+/**
+ * @file LogFormat.cpp
+ * @brief Text formatting and binary packing of run-log records.
+ */
+
+#include "LogFormat.h"
+#include "Admission.h"
+#include "IPBlocker.h"
+
+namespace {
+
+// tag byte: kind in bits 0-3, job type in bits 4-5 (Assign), bit 7 = same cycle as before
+constexpr uint8_t kKindMask = 0x0F;
+constexpr uint8_t kJobShift = 4;
+constexpr uint8_t kJobP = 0, kJobS = 1, kJobRaw = 2;
+constexpr uint8_t kSameCycle = 0x80;
+
+void appendInt(std::string& out, long long v) {
+    char tmp[24];
+    char* p = tmp + sizeof(tmp);
+    unsigned long long u = v < 0 ? 0ull - static_cast<unsigned long long>(v) : static_cast<unsigned long long>(v);
+    do {
+        *--p = static_cast<char>('0' + u % 10);
+        u /= 10;
+    } while (u);
+    if (v < 0) *--p = '-';
+    out.append(p, static_cast<size_t>(tmp + sizeof(tmp) - p));
+}
+
+/** "[0000042] " with the cycle zero-padded to at least 7 digits */
+void appendCycle(std::string& out, int cycle) {
+    out += '[';
+    if (cycle >= 0) {
+        int digits = 1;
+        for (int c = cycle; c >= 10; c /= 10) digits++;
+        if (digits < 7) out.append(static_cast<size_t>(7 - digits), '0');
+    }
+    appendInt(out, cycle);
+    out += "] ";
+}
+
+void putVarint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out += static_cast<char>((v & 0x7F) | 0x80);
+        v >>= 7;
+    }
+    out += static_cast<char>(v);
+}
+
+void putSigned(std::string& out, int64_t v) {
+    putVarint(out, (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));  // zigzag
+}
+
+bool getVarint(const char*& p, const char* end, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (p == end) return false;
+        uint8_t byte = static_cast<uint8_t>(*p++);
+        v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+bool getSigned(const char*& p, const char* end, int64_t& v) {
+    uint64_t u;
+    if (!getVarint(p, end, u)) return false;
+    v = static_cast<int64_t>(u >> 1) ^ -static_cast<int64_t>(u & 1);
+    return true;
+}
+
+} // namespace
+
+void formatLogLine(const LogRecord& r, std::string& out) {
+    appendCycle(out, r.cycle);
+    switch (r.kind) {
+    case LogKind::Assign:
+        out += "ASSIGN server=";
+        appendInt(out, r.a);
+        out += " reqID=";
+        appendInt(out, r.b);
+        out += " svc=";
+        appendInt(out, r.c);
+        out += " job=";
+        out += r.job;
+        break;
+    case LogKind::Complete:
+        out += "COMPLETE server=";
+        appendInt(out, r.a);
+        out += " reqID=";
+        appendInt(out, r.b);
+        out += " queue=";
+        appendInt(out, r.c);
+        break;
+    case LogKind::ScaleUp:
+    case LogKind::ScaleDown:
+        out += r.kind == LogKind::ScaleUp ? "SCALE_UP newServers=" : "SCALE_DOWN newServers=";
+        appendInt(out, r.a);
+        out += " queueSize=";
+        appendInt(out, r.c);
+        break;
+    case LogKind::Blocked:
+        out += "BLOCKED ip=";
+        out += IPBlocker::ipToString(static_cast<uint32_t>(r.c));
+        out += " reason=blocked-range";
+        break;
+    case LogKind::Shed:
+        out += "SHED reqID=";
+        appendInt(out, r.b);
+        out += " reason=";
+        out += shedReasonName(static_cast<ShedReason>(r.a));
+        out += " waited=";
+        appendInt(out, r.c);
+        break;
+    case LogKind::Text:
+    case LogKind::Config:
+        break;
+    }
+    out += '\n';
+}
+
+void BinaryLogEncoder::begin(std::string& out) {
+    out.append(kBinaryLogMagic, sizeof(kBinaryLogMagic));
+    out += static_cast<char>(kBinaryLogVersion);
+}
+
+void BinaryLogEncoder::encode(const LogRecord& r, const std::string* text, std::string& out) {
+    uint8_t tag = static_cast<uint8_t>(r.kind);
+    if (r.kind == LogKind::Text || r.kind == LogKind::Config) {
+        out += static_cast<char>(tag);
+        size_t len = text ? text->size() : 0;
+        putVarint(out, len);
+        if (len) out += *text;
+        return;
+    }
+    bool sameCycle = r.cycle == cycle_;
+    if (sameCycle) tag |= kSameCycle;
+    if (r.kind == LogKind::Assign) {
+        uint8_t job = r.job == 'P' ? kJobP : r.job == 'S' ? kJobS : kJobRaw;
+        tag |= static_cast<uint8_t>(job << kJobShift);
+    }
+    out += static_cast<char>(tag);
+    if (!sameCycle) putSigned(out, static_cast<int64_t>(r.cycle) - cycle_);
+    cycle_ = r.cycle;
+    switch (r.kind) {
+    case LogKind::Assign:
+        putVarint(out, static_cast<uint32_t>(r.a));
+        putSigned(out, static_cast<int64_t>(r.b) - assignId_);
+        assignId_ = r.b;
+        putSigned(out, r.c);
+        if (r.job != 'P' && r.job != 'S') out += r.job;
+        break;
+    case LogKind::Complete:
+        putVarint(out, static_cast<uint32_t>(r.a));
+        putSigned(out, static_cast<int64_t>(r.b) - completeId_);
+        completeId_ = r.b;
+        putSigned(out, r.c - queue_);
+        queue_ = r.c;
+        break;
+    case LogKind::ScaleUp:
+    case LogKind::ScaleDown:
+        putVarint(out, static_cast<uint32_t>(r.a));
+        putSigned(out, r.c - queue_);
+        queue_ = r.c;
+        break;
+    case LogKind::Blocked:
+        for (int i = 0; i < 4; ++i) out += static_cast<char>((static_cast<uint64_t>(r.c) >> (8 * i)) & 0xFF);
+        break;
+    case LogKind::Shed:
+        putVarint(out, static_cast<uint32_t>(r.a));
+        putVarint(out, static_cast<uint32_t>(r.b));
+        putSigned(out, r.c);
+        break;
+    case LogKind::Text:
+    case LogKind::Config:
+        break;
+    }
+}
+
+bool BinaryLogDecoder::begin(const char*& p, const char* end) {
+    if (end - p < static_cast<long>(sizeof(kBinaryLogMagic)) + 1) return false;
+    for (char c : kBinaryLogMagic) {
+        if (*p++ != c) return false;
+    }
+    version_ = static_cast<uint8_t>(*p++);
+    return version_ >= kBinaryLogMinVersion && version_ <= kBinaryLogVersion;
+}
+
+bool BinaryLogDecoder::next(const char*& p, const char* end, LogRecord& r, std::string& text) {
+    if (p == end) return false;
+    uint8_t tag = static_cast<uint8_t>(*p++);
+    uint8_t kind = tag & kKindMask;
+    if (kind > static_cast<uint8_t>(LogKind::Shed)) return false;
+    if (kind == static_cast<uint8_t>(LogKind::Shed) && version_ < 2) return false;
+    r = LogRecord{cycle_, static_cast<LogKind>(kind), 0, 0, 0, 0};
+    uint64_t u;
+    int64_t d;
+    if (r.kind == LogKind::Text || r.kind == LogKind::Config) {
+        if (!getVarint(p, end, u) || static_cast<uint64_t>(end - p) < u) return false;
+        text.assign(p, static_cast<size_t>(u));
+        p += u;
+        return true;
+    }
+    if (!(tag & kSameCycle)) {
+        if (!getSigned(p, end, d)) return false;
+        cycle_ = static_cast<int32_t>(cycle_ + d);
+    }
+    r.cycle = cycle_;
+    switch (r.kind) {
+    case LogKind::Assign: {
+        if (!getVarint(p, end, u)) return false;
+        r.a = static_cast<int32_t>(u);
+        if (!getSigned(p, end, d)) return false;
+        assignId_ = static_cast<int32_t>(assignId_ + d);
+        r.b = assignId_;
+        if (!getSigned(p, end, r.c)) return false;
+        uint8_t job = (tag >> kJobShift) & 0x3;
+        if (job == kJobRaw) {
+            if (p == end) return false;
+            r.job = *p++;
+        } else {
+            r.job = job == kJobS ? 'S' : 'P';
+        }
+        break;
+    }
+    case LogKind::Complete:
+        if (!getVarint(p, end, u)) return false;
+        r.a = static_cast<int32_t>(u);
+        if (!getSigned(p, end, d)) return false;
+        completeId_ = static_cast<int32_t>(completeId_ + d);
+        r.b = completeId_;
+        if (!getSigned(p, end, d)) return false;
+        queue_ += d;
+        r.c = queue_;
+        break;
+    case LogKind::ScaleUp:
+    case LogKind::ScaleDown:
+        if (!getVarint(p, end, u)) return false;
+        r.a = static_cast<int32_t>(u);
+        if (!getSigned(p, end, d)) return false;
+        queue_ += d;
+        r.c = queue_;
+        break;
+    case LogKind::Blocked: {
+        if (end - p < 4) return false;
+        uint64_t ip = 0;
+        for (int i = 0; i < 4; ++i) ip |= static_cast<uint64_t>(static_cast<uint8_t>(*p++)) << (8 * i);
+        r.c = static_cast<int64_t>(ip);
+        break;
+    }
+    case LogKind::Shed:
+        if (!getVarint(p, end, u)) return false;
+        r.a = static_cast<int32_t>(u);
+        if (!getVarint(p, end, u)) return false;
+        r.b = static_cast<int32_t>(u);
+        if (!getSigned(p, end, r.c)) return false;
+        break;
+    case LogKind::Text:
+    case LogKind::Config:
+        break;
+    }
+    return true;
+}
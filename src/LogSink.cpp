@@ -0,0 +1,160 @@
+/**
+ * @file LogSink.cpp
+ * @brief Implementation of LogSink: record ring and writer thread.
+ */
+
+#include "LogSink.h"
+#include <chrono>
+
+namespace {
+
+constexpr size_t kWriteBlock = 1 << 20;  /**< bytes encoded before each fwrite */
+
+} // namespace
+
+bool parseLogLevel(const std::string& name, LogLevel& level) {
+    if (name == "all") level = LogLevel::All;
+    else if (name == "scale") level = LogLevel::Scale;
+    else if (name == "summary") level = LogLevel::Summary;
+    else if (name == "none") level = LogLevel::None;
+    else return false;
+    return true;
+}
+
+bool parseLogEncoding(const std::string& name, LogEncoding& encoding) {
+    if (name == "text") encoding = LogEncoding::Text;
+    else if (name == "binary") encoding = LogEncoding::Binary;
+    else return false;
+    return true;
+}
+
+LogSink::~LogSink() {
+    close();
+}
+
+bool LogSink::open(const std::string& path, LogLevel level, LogEncoding encoding) {
+    close();
+    if (level == LogLevel::None) return false;
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) return false;
+    auto bit = [](LogKind k) { return 1u << static_cast<unsigned>(k); };
+    mask_ = bit(LogKind::Text);
+    if (encoding == LogEncoding::Binary) mask_ |= bit(LogKind::Config);
+    if (level == LogLevel::All || level == LogLevel::Scale) mask_ |= bit(LogKind::ScaleUp) | bit(LogKind::ScaleDown);
+    if (level == LogLevel::All) mask_ |= bit(LogKind::Assign) | bit(LogKind::Complete) | bit(LogKind::Blocked) | bit(LogKind::Shed);
+    encoding_ = encoding;
+    encoder_ = BinaryLogEncoder();
+    if (encoding_ == LogEncoding::Binary) {
+        std::string header;
+        encoder_.begin(header);
+        std::fwrite(header.data(), 1, header.size(), file_);
+    }
+    ring_.reset(new LogRecord[kRingSize]);
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
+    cachedHead_ = 0;
+    stop_.store(false, std::memory_order_relaxed);
+    writer_ = std::thread(&LogSink::writerLoop, this);
+    return true;
+}
+
+void LogSink::assign(int cycle, int server, int reqId, int serviceTime, char jobType) {
+    if (wants(LogKind::Assign)) push({cycle, LogKind::Assign, jobType, server, reqId, serviceTime});
+}
+
+void LogSink::complete(int cycle, int server, int reqId, size_t queueSize) {
+    if (wants(LogKind::Complete)) push({cycle, LogKind::Complete, 0, server, reqId, static_cast<int64_t>(queueSize)});
+}
+
+void LogSink::scaleUp(int cycle, int servers, size_t queueSize) {
+    if (wants(LogKind::ScaleUp)) push({cycle, LogKind::ScaleUp, 0, servers, 0, static_cast<int64_t>(queueSize)});
+}
+
+void LogSink::scaleDown(int cycle, int servers, size_t queueSize) {
+    if (wants(LogKind::ScaleDown)) push({cycle, LogKind::ScaleDown, 0, servers, 0, static_cast<int64_t>(queueSize)});
+}
+
+void LogSink::blocked(int cycle, uint32_t ip) {
+    if (wants(LogKind::Blocked)) push({cycle, LogKind::Blocked, 0, 0, 0, static_cast<int64_t>(ip)});
+}
+
+void LogSink::shed(int cycle, int reqId, uint8_t reason, int waited) {
+    if (wants(LogKind::Shed)) push({cycle, LogKind::Shed, 0, reason, reqId, waited});
+}
+
+void LogSink::text(const std::string& s) {
+    queueText(LogKind::Text, s);
+}
+
+void LogSink::config(const std::string& s) {
+    queueText(LogKind::Config, s);
+}
+
+void LogSink::queueText(LogKind kind, const std::string& s) {
+    if (!wants(kind)) return;
+    {
+        std::lock_guard<std::mutex> lock(textMutex_);
+        texts_.push_back(s);
+    }
+    push({0, kind, 0, 0, 0, 0});
+}
+
+void LogSink::close() {
+    if (!file_) return;
+    stop_.store(true, std::memory_order_release);
+    writer_.join();
+    std::fclose(file_);
+    file_ = nullptr;
+    mask_ = 0;
+}
+
+void LogSink::push(const LogRecord& r) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    while (tail - cachedHead_ >= kRingSize) {
+        // writer is a full ring behind: wait for it rather than drop lines
+        cachedHead_ = head_.load(std::memory_order_acquire);
+        if (tail - cachedHead_ >= kRingSize) std::this_thread::yield();
+    }
+    ring_[tail & (kRingSize - 1)] = r;
+    tail_.store(tail + 1, std::memory_order_release);
+}
+
+void LogSink::writerLoop() {
+    std::string buf;
+    buf.reserve(kWriteBlock + 256);
+    for (;;) {
+        // read stop first: everything pushed before close() is then visible below
+        bool stopping = stop_.load(std::memory_order_acquire);
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        size_t start = head;
+        for (; head != tail; ++head) {
+            encode(ring_[head & (kRingSize - 1)], buf);
+            if (buf.size() >= kWriteBlock) {
+                std::fwrite(buf.data(), 1, buf.size(), file_);
+                buf.clear();
+                head_.store(head + 1, std::memory_order_release);
+            }
+        }
+        head_.store(head, std::memory_order_release);
+        if (head != start) continue;  // keep draining while records arrive
+        if (!buf.empty()) {
+            std::fwrite(buf.data(), 1, buf.size(), file_);
+            buf.clear();
+        }
+        if (stopping) break;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+}
+
+void LogSink::encode(const LogRecord& r, std::string& out) {
+    std::string payload;
+    if (r.kind == LogKind::Text || r.kind == LogKind::Config) {
+        std::lock_guard<std::mutex> lock(textMutex_);
+        payload.swap(texts_.front());
+        texts_.pop_front();
+    }
+    if (encoding_ == LogEncoding::Binary) encoder_.encode(r, &payload, out);
+    else if (r.kind == LogKind::Text) out += payload;
+    else formatLogLine(r, out);
+}
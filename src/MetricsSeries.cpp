@@ -0,0 +1,118 @@
+/**
+ * @file MetricsSeries.cpp
+ * @brief Implementation of MetricsSeries: sampling buffer and CSV / Prometheus export.
+ */
+
+#include "MetricsSeries.h"
+#include <algorithm>
+#include <fstream>
+
+namespace {
+
+struct Column {
+    const char* name;
+    const char* help;
+    bool counter;
+};
+
+const Column kColumns[] = {
+    {"queue_depth", "Requests waiting in the queue", false},
+    {"active_servers", "Active (provisioned) servers", false},
+    {"in_flight", "Requests being served", false},
+    {"arrivals_total", "Requests that entered the queue", true},
+    {"completions_total", "Requests completed", true},
+    {"blocked_total", "Requests dropped by the IP blocker", true},
+};
+
+} // namespace
+
+bool parseMetricsFormat(const std::string& name, MetricsFormat& format) {
+    if (name == "csv") format = MetricsFormat::Csv;
+    else if (name == "prom" || name == "prometheus") format = MetricsFormat::Prometheus;
+    else return false;
+    return true;
+}
+
+void MetricsSeries::reset(int interval, int runTime) {
+    interval_ = interval > 0 ? interval : 0;
+    next_ = interval_ > 0 ? interval_ - 1 : INT_MAX;
+    size_t n = interval_ > 0 && runTime > 0 ? static_cast<size_t>(runTime / interval_) : 0;
+    for (auto* v : {&cycle_, &active_, &inFlight_}) {
+        v->clear();
+        v->reserve(n);
+    }
+    queue_.clear();
+    queue_.reserve(n);
+    for (auto* v : {&arrivals_, &completions_, &blocked_}) {
+        v->clear();
+        v->reserve(n);
+    }
+}
+
+void MetricsSeries::record(int64_t queue, int active, int inFlight, uint64_t arrivals, uint64_t completions,
+                           uint64_t blocked) {
+    cycle_.push_back(next_);
+    queue_.push_back(queue);
+    active_.push_back(active);
+    inFlight_.push_back(inFlight);
+    arrivals_.push_back(arrivals);
+    completions_.push_back(completions);
+    blocked_.push_back(blocked);
+    next_ = next_ > INT_MAX - interval_ ? INT_MAX : next_ + interval_;
+}
+
+void MetricsSeries::accumulate(const MetricsSeries& other) {
+    size_t n = std::min(size(), other.size());
+    for (size_t i = 0; i < n; ++i) {
+        queue_[i] += other.queue_[i];
+        active_[i] += other.active_[i];
+        inFlight_[i] += other.inFlight_[i];
+        arrivals_[i] += other.arrivals_[i];
+        completions_[i] += other.completions_[i];
+        blocked_[i] += other.blocked_[i];
+    }
+}
+
+bool MetricsSeries::writeFile(const std::string& path, MetricsFormat format,
+                              const std::vector<std::pair<std::string, const MetricsSeries*>>& series) {
+    std::ofstream out(path);
+    if (!out) return false;
+    // one row of values per sample, in kColumns order
+    auto value = [](const MetricsSeries& s, size_t col, size_t i) -> long long {
+        switch (col) {
+        case 0: return s.queue_[i];
+        case 1: return s.active_[i];
+        case 2: return s.inFlight_[i];
+        case 3: return static_cast<long long>(s.arrivals_[i]);
+        case 4: return static_cast<long long>(s.completions_[i]);
+        default: return static_cast<long long>(s.blocked_[i]);
+        }
+    };
+    constexpr size_t kColumnCount = sizeof(kColumns) / sizeof(kColumns[0]);
+
+    if (format == MetricsFormat::Csv) {
+        out << "lb,cycle";
+        for (const Column& c : kColumns) out << "," << c.name;
+        out << "\n";
+        for (const auto& [label, s] : series) {
+            for (size_t i = 0; i < s->size(); ++i) {
+                out << label << "," << s->cycle_[i];
+                for (size_t col = 0; col < kColumnCount; ++col) out << "," << value(*s, col, i);
+                out << "\n";
+            }
+        }
+    } else {
+        for (size_t col = 0; col < kColumnCount; ++col) {
+            const Column& c = kColumns[col];
+            out << "# HELP bizaco_" << c.name << " " << c.help << " (timestamp = cycle)\n";
+            out << "# TYPE bizaco_" << c.name << " " << (c.counter ? "counter" : "gauge") << "\n";
+            for (const auto& [label, s] : series) {
+                for (size_t i = 0; i < s->size(); ++i)
+                    out << "bizaco_" << c.name << "{lb=\"" << label << "\"} " << value(*s, col, i) << " "
+                        << s->cycle_[i] << "\n";
+            }
+        }
+    }
+    out.flush();
+    return static_cast<bool>(out);
+}
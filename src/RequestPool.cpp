@@ -0,0 +1,32 @@
+/**
+ * @file RequestPool.cpp
+ * @brief Implementation of RequestPool.
+ */
+
+#include "RequestPool.h"
+
+RequestHandle RequestPool::acquire(const Request& r) {
+    RequestHandle h;
+    if (!free_.empty()) {
+        h = free_.back();
+        free_.pop_back();
+    } else {
+        if ((used_ >> kSlabShift) == slabs_.size())
+            slabs_.push_back(std::make_unique<Request[]>(size_t{1} << kSlabShift));
+        h = used_++;
+    }
+    get(h) = r;
+    return h;
+}
+
+void RequestPool::release(RequestHandle h) {
+    free_.push_back(h);
+}
+
+size_t RequestPool::size() const {
+    return used_ - free_.size();
+}
+
+size_t RequestPool::capacity() const {
+    return slabs_.size() << kSlabShift;
+}
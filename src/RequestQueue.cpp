@@ -4,22 +4,58 @@
  */
 
 #include "RequestQueue.h"
+#include <algorithm>
 
-void RequestQueue::enqueue(const Request& r) {
-    queue_.push(r);
+void RequestQueue::enqueue(RequestHandle h) {
+    if (count_ == buf_.size()) grow(count_ + 1);
+    buf_[(head_ + count_) & (buf_.size() - 1)] = h;
+    count_++;
 }
 
-bool RequestQueue::try_dequeue(Request& out) {
-    if (queue_.empty()) return false;
-    out = queue_.front();
-    queue_.pop();
+bool RequestQueue::try_dequeue(RequestHandle& out) {
+    if (count_ == 0) return false;
+    out = buf_[head_];
+    head_ = (head_ + 1) & (buf_.size() - 1);
+    count_--;
     return true;
 }
 
+bool RequestQueue::peek(RequestHandle& out) const {
+    if (count_ == 0) return false;
+    out = buf_[head_];
+    return true;
+}
+
+size_t RequestQueue::dequeue_batch(RequestHandle* out, size_t n) {
+    n = std::min(n, count_);
+    // at most two contiguous runs: up to the end of the buffer, then from the start
+    size_t first = std::min(n, buf_.size() - head_);
+    std::copy_n(buf_.begin() + static_cast<std::ptrdiff_t>(head_), first, out);
+    std::copy_n(buf_.begin(), n - first, out + first);
+    if (n) head_ = (head_ + n) & (buf_.size() - 1);
+    count_ -= n;
+    return n;
+}
+
+void RequestQueue::reserve(size_t n) {
+    if (n > buf_.size()) grow(n);
+}
+
 size_t RequestQueue::size() const {
-    return queue_.size();
+    return count_;
 }
 
 bool RequestQueue::empty() const {
-    return queue_.empty();
+    return count_ == 0;
+}
+
+void RequestQueue::grow(size_t minCapacity) {
+    size_t cap = buf_.empty() ? 16 : buf_.size();
+    while (cap < minCapacity) cap *= 2;
+    std::vector<RequestHandle> bigger(cap);
+    size_t first = std::min(count_, buf_.size() - head_);
+    std::copy_n(buf_.begin() + static_cast<std::ptrdiff_t>(head_), first, bigger.begin());
+    std::copy_n(buf_.begin(), count_ - first, bigger.begin() + static_cast<std::ptrdiff_t>(first));
+    buf_.swap(bigger);
+    head_ = 0;
 }
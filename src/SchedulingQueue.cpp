@@ -0,0 +1,219 @@
+/**
+ * @file SchedulingQueue.cpp
+ * @brief Implementation of SchedulingQueue: FIFO ring, per-job-type lists and the sjf heap.
+ */
+
+#include "SchedulingQueue.h"
+#include <algorithm>
+#include <sstream>
+
+bool parseQueueDiscipline(const std::string& s, QueueDiscipline& d) {
+    if (s == "fifo") d = QueueDiscipline::Fifo;
+    else if (s == "priority") d = QueueDiscipline::Priority;
+    else if (s == "sjf") d = QueueDiscipline::Sjf;
+    else if (s == "edf") d = QueueDiscipline::Edf;
+    else if (s == "wfq") d = QueueDiscipline::Wfq;
+    else return false;
+    return true;
+}
+
+SchedulingQueue::SchedulingQueue(const Config& cfg, const RequestPool& pool) : pool_(pool) {
+    parseQueueDiscipline(cfg.queueDiscipline, discipline_);
+    first_ = jobTypeIndex(cfg.priorityJobType.empty() ? 'S' : cfg.priorityJobType[0]);
+    deadline_[kStreaming] = std::max(cfg.streamingDeadline, 0);
+    deadline_[kProcessing] = std::max(cfg.processingDeadline, 0);
+    cost_[kStreaming] = 1.0 / std::max(cfg.streamingWeight, 1);
+    cost_[kProcessing] = 1.0 / std::max(cfg.processingWeight, 1);
+}
+
+void SchedulingQueue::enqueue(RequestHandle h) {
+    if (discipline_ == QueueDiscipline::Fifo) {
+        fifo_.enqueue(h);
+        return;
+    }
+    if (h >= node_.size()) grow(static_cast<size_t>(h) + 1);
+    const Request& r = pool_.get(h);
+    Node& n = node_[h];
+    n.agePrev = age_.tail;
+    n.ageNext = kNoRequest;
+    if (age_.tail != kNoRequest) node_[age_.tail].ageNext = h;
+    else age_.head = h;
+    age_.tail = h;
+    count_++;
+    if (discipline_ == QueueDiscipline::Sjf) {
+        heap_.push_back({r.serviceTime, r.id, h});
+        heapPos_[h] = static_cast<uint32_t>(heap_.size() - 1);
+        siftUp(heap_.size() - 1);
+        return;
+    }
+    size_t t = jobTypeIndex(r.jobType);
+    if (discipline_ == QueueDiscipline::Wfq) {
+        // finish tag: from the later of now (virtual) and the job type's last tag
+        tag_[h] = std::max(vtime_, lastTag_[t]) + r.serviceTime * cost_[t];
+        lastTag_[t] = tag_[h];
+    }
+    pushLane(lanes_[t], h);
+}
+
+long SchedulingQueue::pickLane() const {
+    const List& s = lanes_[kStreaming];
+    const List& p = lanes_[kProcessing];
+    if (s.head == kNoRequest) return p.head == kNoRequest ? -1 : static_cast<long>(kProcessing);
+    if (p.head == kNoRequest) return static_cast<long>(kStreaming);
+    if (discipline_ == QueueDiscipline::Priority) return static_cast<long>(first_);
+    const Request& a = pool_.get(s.head);
+    const Request& b = pool_.get(p.head);
+    // ties go to the earlier req
+    bool streaming;
+    if (discipline_ == QueueDiscipline::Edf) {
+        long long da = static_cast<long long>(a.arrivalTime) + deadline_[kStreaming];
+        long long db = static_cast<long long>(b.arrivalTime) + deadline_[kProcessing];
+        streaming = da < db || (da == db && a.id < b.id);
+    } else {
+        double ta = tag_[s.head], tb = tag_[p.head];
+        streaming = ta < tb || (ta == tb && a.id < b.id);
+    }
+    return static_cast<long>(streaming ? kStreaming : kProcessing);
+}
+
+bool SchedulingQueue::peek(RequestHandle& out) const {
+    if (discipline_ == QueueDiscipline::Fifo) return fifo_.peek(out);
+    if (count_ == 0) return false;
+    out = discipline_ == QueueDiscipline::Sjf ? heap_[0].h : lanes_[static_cast<size_t>(pickLane())].head;
+    return true;
+}
+
+bool SchedulingQueue::try_dequeue(RequestHandle& out) {
+    if (discipline_ == QueueDiscipline::Fifo) return fifo_.try_dequeue(out);
+    if (!peek(out)) return false;
+    if (discipline_ == QueueDiscipline::Wfq) vtime_ = tag_[out];
+    remove(out);
+    return true;
+}
+
+size_t SchedulingQueue::dequeue_batch(RequestHandle* out, size_t n) {
+    if (discipline_ == QueueDiscipline::Fifo) return fifo_.dequeue_batch(out, n);
+    size_t k = 0;
+    while (k < n && try_dequeue(out[k])) ++k;
+    return k;
+}
+
+bool SchedulingQueue::peekOldest(RequestHandle& out) const {
+    if (discipline_ == QueueDiscipline::Fifo) return fifo_.peek(out);
+    if (count_ == 0) return false;
+    out = age_.head;
+    return true;
+}
+
+bool SchedulingQueue::removeOldest(RequestHandle& out) {
+    if (discipline_ == QueueDiscipline::Fifo) return fifo_.try_dequeue(out);
+    if (!peekOldest(out)) return false;
+    remove(out);
+    return true;
+}
+
+void SchedulingQueue::reserve(size_t n) {
+    if (discipline_ == QueueDiscipline::Fifo) {
+        fifo_.reserve(n);
+        return;
+    }
+    if (n > node_.size()) grow(n);
+    if (discipline_ == QueueDiscipline::Sjf) heap_.reserve(n);
+}
+
+void SchedulingQueue::grow(size_t handles) {
+    size_t size = std::max(handles, node_.size() * 2);
+    node_.resize(size);
+    if (discipline_ == QueueDiscipline::Wfq) tag_.resize(size);
+    if (discipline_ == QueueDiscipline::Sjf) heapPos_.resize(size);
+}
+
+void SchedulingQueue::remove(RequestHandle h) {
+    Node& n = node_[h];
+    if (n.agePrev != kNoRequest) node_[n.agePrev].ageNext = n.ageNext;
+    else age_.head = n.ageNext;
+    if (n.ageNext != kNoRequest) node_[n.ageNext].agePrev = n.agePrev;
+    else age_.tail = n.agePrev;
+    count_--;
+    if (discipline_ == QueueDiscipline::Sjf) heapErase(heapPos_[h]);
+    else unlinkLane(lanes_[jobTypeIndex(pool_.get(h).jobType)], h);
+}
+
+void SchedulingQueue::pushLane(List& l, RequestHandle h) {
+    Node& n = node_[h];
+    n.prev = l.tail;
+    n.next = kNoRequest;
+    if (l.tail != kNoRequest) node_[l.tail].next = h;
+    else l.head = h;
+    l.tail = h;
+}
+
+void SchedulingQueue::unlinkLane(List& l, RequestHandle h) {
+    Node& n = node_[h];
+    if (n.prev != kNoRequest) node_[n.prev].next = n.next;
+    else l.head = n.next;
+    if (n.next != kNoRequest) node_[n.next].prev = n.prev;
+    else l.tail = n.prev;
+}
+
+void SchedulingQueue::place(size_t i, const HeapEntry& e) {
+    heap_[i] = e;
+    heapPos_[e.h] = static_cast<uint32_t>(i);
+}
+
+void SchedulingQueue::siftUp(size_t i) {
+    HeapEntry e = heap_[i];
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!before(e, heap_[parent])) break;
+        place(i, heap_[parent]);
+        i = parent;
+    }
+    place(i, e);
+}
+
+void SchedulingQueue::siftDown(size_t i) {
+    HeapEntry e = heap_[i];
+    size_t n = heap_.size();
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= n) break;
+        if (child + 1 < n && before(heap_[child + 1], heap_[child])) ++child;
+        if (!before(heap_[child], e)) break;
+        place(i, heap_[child]);
+        i = child;
+    }
+    place(i, e);
+}
+
+void SchedulingQueue::heapErase(size_t i) {
+    HeapEntry last = heap_.back();
+    heap_.pop_back();
+    if (i == heap_.size()) return;
+    // the last entry takes the hole and moves whichever way it belongs
+    place(i, last);
+    if (i > 0 && before(last, heap_[(i - 1) / 2])) siftUp(i);
+    else siftDown(i);
+}
+
+std::string SchedulingQueue::describe() const {
+    std::ostringstream os;
+    switch (discipline_) {
+    case QueueDiscipline::Fifo:
+        os << "fifo";
+        break;
+    case QueueDiscipline::Priority:
+        os << "priority (" << (first_ == kStreaming ? "S" : "P") << " first)";
+        break;
+    case QueueDiscipline::Sjf:
+        os << "sjf (shortest service time first)";
+        break;
+    case QueueDiscipline::Edf:
+        os << "edf (deadline S " << deadline_[kStreaming] << ", P " << deadline_[kProcessing] << " cycles)";
+        break;
+    case QueueDiscipline::Wfq:
+        os << "wfq (weight S " << 1 / cost_[kStreaming] << ", P " << 1 / cost_[kProcessing] << ")";
+        break;
+    }
+    return os.str();
+}
@@ -0,0 +1,72 @@
+/**
+ * @file ServerSet.cpp
+ * @brief Implementation of ServerSet.
+ */
+
+#include "ServerSet.h"
+
+void ServerSet::resize(size_t n) {
+    size_t words = (n + 63) / 64;
+    if (words > words_.size()) {
+        words_.resize(words, 0);
+        summary_.resize((words + 63) / 64, 0);
+    }
+}
+
+void ServerSet::insert(size_t i) {
+    uint64_t& w = words_[i >> 6];
+    uint64_t bit = uint64_t{1} << (i & 63);
+    if (w & bit) return;
+    w |= bit;
+    summary_[i >> 12] |= uint64_t{1} << ((i >> 6) & 63);
+    count_++;
+}
+
+void ServerSet::erase(size_t i) {
+    uint64_t& w = words_[i >> 6];
+    uint64_t bit = uint64_t{1} << (i & 63);
+    if (!(w & bit)) return;
+    w &= ~bit;
+    if (!w) summary_[i >> 12] &= ~(uint64_t{1} << ((i >> 6) & 63));
+    count_--;
+}
+
+bool ServerSet::contains(size_t i) const {
+    return (i >> 6) < words_.size() && ((words_[i >> 6] >> (i & 63)) & 1);
+}
+
+long ServerSet::first() const {
+    for (size_t s = 0; s < summary_.size(); ++s) {
+        if (!summary_[s]) continue;
+        size_t w = s * 64 + static_cast<size_t>(__builtin_ctzll(summary_[s]));
+        return static_cast<long>(w * 64 + static_cast<size_t>(__builtin_ctzll(words_[w])));
+    }
+    return -1;
+}
+
+long ServerSet::next(size_t i) const {
+    size_t w = i / 64;
+    if (w >= words_.size()) return -1;
+    uint64_t bits = words_[w] & (~uint64_t{0} << (i % 64));
+    if (bits) return static_cast<long>(w * 64 + static_cast<size_t>(__builtin_ctzll(bits)));
+    // rest of this summary word, then whole summary words
+    size_t s = w / 64;
+    uint64_t sum = (w % 64 == 63) ? 0 : summary_[s] & (~uint64_t{0} << (w % 64 + 1));
+    for (;;) {
+        if (sum) {
+            size_t nw = s * 64 + static_cast<size_t>(__builtin_ctzll(sum));
+            return static_cast<long>(nw * 64 + static_cast<size_t>(__builtin_ctzll(words_[nw])));
+        }
+        if (++s >= summary_.size()) return -1;
+        sum = summary_[s];
+    }
+}
+
+long ServerSet::last() const {
+    for (size_t s = summary_.size(); s-- > 0;) {
+        if (!summary_[s]) continue;
+        size_t w = s * 64 + 63 - static_cast<size_t>(__builtin_clzll(summary_[s]));
+        return static_cast<long>(w * 64 + 63 - static_cast<size_t>(__builtin_clzll(words_[w])));
+    }
+    return -1;
+}
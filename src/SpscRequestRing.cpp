@@ -0,0 +1,37 @@
+/**
+ * @file SpscRequestRing.cpp
+ * @brief Implementation of SpscRequestRing.
+ */
+
+#include "SpscRequestRing.h"
+
+SpscRequestRing::SpscRequestRing(size_t capacity) {
+    size_t cap = 2;
+    while (cap < capacity) cap *= 2;
+    buf_.reset(new Request[cap]);
+    mask_ = cap - 1;
+}
+
+bool SpscRequestRing::try_push(const Request& r) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cachedHead_ > mask_) {
+        cachedHead_ = head_.load(std::memory_order_acquire);
+        if (tail - cachedHead_ > mask_) return false;
+    }
+    buf_[tail & mask_] = r;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+const Request* SpscRequestRing::peek() {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cachedTail_) {
+        cachedTail_ = tail_.load(std::memory_order_acquire);
+        if (head == cachedTail_) return nullptr;
+    }
+    return &buf_[head & mask_];
+}
+
+void SpscRequestRing::pop() {
+    head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
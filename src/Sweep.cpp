@@ -0,0 +1,200 @@
+/**
+ * @file Sweep.cpp
+ * @brief Implementation of Sweep: grid expansion, thread pool, CSV aggregation.
+ */
+
+#include "Sweep.h"
+#include "LoadBalancer.h"
+#include <fstream>
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <iomanip>
+
+namespace {
+
+/** Metrics aggregated per grid point, in CSV column order */
+const char* const kMetricNames[] = {"peak_queue", "avg_queue", "completed", "scale_ups", "scale_downs",
+                                    "server_cycles", "utilization", "wait_p99", "shed"};
+constexpr size_t kMetricCount = sizeof(kMetricNames) / sizeof(kMetricNames[0]);
+
+std::string trim(const std::string& s) {
+    auto start = s.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) return "";
+    auto end = s.find_last_not_of(" \t\r\n");
+    return s.substr(start, end - start + 1);
+}
+
+/** Expand "a,b,lo:hi[:step]" into its values; a lone value yields one entry */
+std::vector<std::string> expandValues(const std::string& val) {
+    std::vector<std::string> out;
+    size_t start = 0;
+    while (start <= val.size()) {
+        size_t comma = val.find(',', start);
+        std::string one = trim(val.substr(start, comma == std::string::npos ? std::string::npos : comma - start));
+        size_t c1 = one.find(':');
+        if (c1 != std::string::npos) {
+            size_t c2 = one.find(':', c1 + 1);
+            try {
+                long lo = std::stol(one.substr(0, c1));
+                long hi = std::stol(one.substr(c1 + 1, c2 == std::string::npos ? std::string::npos : c2 - c1 - 1));
+                long step = c2 == std::string::npos ? 1 : std::stol(one.substr(c2 + 1));
+                if (step <= 0) step = 1;
+                for (long v = lo; v <= hi; v += step) out.push_back(std::to_string(v));
+            } catch (...) {
+                // malformed range: skipped, like an unparsable config value
+            }
+        } else if (!one.empty()) {
+            out.push_back(one);
+        }
+        if (comma == std::string::npos) break;
+        start = comma + 1;
+    }
+    return out;
+}
+
+/** p95 by nearest rank; sorts v */
+double percentile95(std::vector<double>& v) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    size_t rank = (95 * v.size() + 99) / 100;
+    return v[std::max<size_t>(rank, 1) - 1];
+}
+
+} // namespace
+
+Sweep::Sweep(const Config& base) : base_(base) {}
+
+bool Sweep::loadFromFile(const std::string& path) {
+    std::ifstream f(path);
+    if (!f) return false;
+    std::string line;
+    while (std::getline(f, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') continue;
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) continue;
+        std::string key = trim(line.substr(0, eq));
+        std::string val = trim(line.substr(eq + 1));
+        if (key == "seeds") {
+            seeds_ = std::max(1, std::atoi(val.c_str()));
+            continue;
+        }
+        if (key == "seedBase") {
+            seedBase_ = static_cast<unsigned int>(std::strtoul(val.c_str(), nullptr, 10));
+            if (seedBase_ == 0) seedBase_ = 1;  // seed 0 would mean a random seed
+            continue;
+        }
+        // range lists are comma separated by nature, never an axis
+        bool rangeList = key == "blockedRange" || key == "blockedRanges" || key == "allowedRange" || key == "allowedRanges";
+        std::vector<std::string> values = rangeList ? std::vector<std::string>{val} : expandValues(val);
+        if (values.size() > 1) {
+            axes_.push_back({key, values});
+        } else if (!values.empty()) {
+            base_.set(key, values[0]);
+        }
+    }
+    return true;
+}
+
+size_t Sweep::pointCount() const {
+    size_t n = 1;
+    for (const Axis& a : axes_) n *= a.values.size();
+    return n;
+}
+
+size_t Sweep::runCount() const {
+    return pointCount() * static_cast<size_t>(seeds_);
+}
+
+Config Sweep::pointConfig(size_t point) const {
+    // last axis varies fastest
+    Config cfg = base_;
+    for (size_t i = axes_.size(); i-- > 0;) {
+        const Axis& a = axes_[i];
+        cfg.set(a.key, a.values[point % a.values.size()]);
+        point /= a.values.size();
+    }
+    return cfg;
+}
+
+bool Sweep::run(int threads, const std::string& csvPath, std::ostream* progress) {
+    std::ofstream csv(csvPath);
+    if (!csv) return false;
+
+    size_t points = pointCount();
+    size_t runs = runCount();
+    size_t seeds = static_cast<size_t>(seeds_);
+    size_t workers = threads > 0 ? static_cast<size_t>(threads) : std::max(1u, std::thread::hardware_concurrency());
+    workers = std::min(workers, runs);
+    if (progress)
+        *progress << "Sweep: " << points << " grid points x " << seeds << " seeds = " << runs
+                  << " runs on " << workers << " threads\n" << std::flush;
+
+    std::vector<Config> configs;
+    configs.reserve(points);
+    for (size_t p = 0; p < points; ++p) configs.push_back(pointConfig(p));
+
+    // results[run][metric]; run = point * seeds + seed index
+    std::vector<double> results(runs * kMetricCount);
+    std::atomic<size_t> next{0};
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (size_t w = 0; w < workers; ++w) {
+        pool.emplace_back([&] {
+            for (size_t run = next.fetch_add(1); run < runs; run = next.fetch_add(1)) {
+                Config cfg = configs[run / seeds];
+                cfg.seed = seedBase_ + static_cast<unsigned int>(run % seeds);
+                if (cfg.initialQueueSize <= 0) cfg.initialQueueSize = cfg.initialServers * 100;
+                LoadBalancer lb(cfg);
+                lb.shareIPBlocker(ipBlocker_);
+                lb.runSimulation();
+                LoadBalancer::Metrics m = lb.getMetrics();
+                double* out = &results[run * kMetricCount];
+                out[0] = static_cast<double>(m.peakQueue);
+                out[1] = m.avgQueue;
+                out[2] = static_cast<double>(m.completed);
+                out[3] = m.scaleUps;
+                out[4] = m.scaleDowns;
+                out[5] = static_cast<double>(m.serverCycles);
+                out[6] = m.utilization;
+                out[7] = static_cast<double>(m.waitP99);
+                out[8] = static_cast<double>(m.rejected);
+            }
+        });
+    }
+    for (std::thread& t : pool) t.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (const Axis& a : axes_) csv << a.key << ",";
+    csv << "runs";
+    for (const char* name : kMetricNames) csv << "," << name << "_mean," << name << "_p95";
+    csv << "\n";
+    csv << std::fixed << std::setprecision(2);
+    std::vector<double> column(seeds);
+    for (size_t p = 0; p < points; ++p) {
+        size_t rest = p;
+        std::vector<std::string> cells(axes_.size());
+        for (size_t i = axes_.size(); i-- > 0;) {
+            cells[i] = axes_[i].values[rest % axes_[i].values.size()];
+            rest /= axes_[i].values.size();
+        }
+        for (const std::string& c : cells) csv << c << ",";
+        csv << seeds;
+        for (size_t k = 0; k < kMetricCount; ++k) {
+            double sum = 0;
+            for (size_t s = 0; s < seeds; ++s) {
+                column[s] = results[(p * seeds + s) * kMetricCount + k];
+                sum += column[s];
+            }
+            csv << "," << sum / seeds << "," << percentile95(column);
+        }
+        csv << "\n";
+    }
+    if (progress)
+        *progress << "Sweep done in " << std::fixed << std::setprecision(2) << secs << " s ("
+                  << std::setprecision(1) << (secs > 0 ? runs / secs : 0) << " runs/s)\n";
+    return true;
+}
@@ -5,21 +5,30 @@
 
 #include "Switch.h"
 #include <iomanip>
-#include <sstream>
+#include <algorithm>
+#include <thread>
 
 namespace {
 
-std::string randomIp(std::mt19937& rng) {
-    std::uniform_int_distribution<int> u(0, 255);
-    std::ostringstream os;
-    os << u(rng) << '.' << u(rng) << '.' << u(rng) << '.' << u(rng);
-    return os.str();
+constexpr int kTraceChunk = 4096;   /**< initial-queue trace records routed per pass */
+constexpr int kEpochCycles = 1024;   /**< parallel mode: cycles between watermark publications */
+constexpr size_t kLaneRingSize = 4096;  /**< parallel mode: reqs buffered per lane */
+
+/** Lane: queue the pushed reqs arriving at cycle t (before t is run) */
+void takeLaneArrivals(LoadBalancer& lb, SpscRequestRing& ring, int t) {
+    lb.skipTo(t);
+    for (const Request* r = ring.peek(); r && r->arrivalTime == t; r = ring.peek()) {
+        lb.enqueueRequest(*r);
+        ring.pop();
+    }
 }
 
 } // namespace
 
 Switch::Switch(const Config& cfg)
-    : cfg_(cfg), lbStreaming_(cfg), lbProcessing_(cfg) {}
+    : cfg_(cfg), lbStreaming_(cfg), lbProcessing_(cfg), workload_(cfg) {
+    metrics_.reset(cfg_.metricsInterval, cfg_.runTime);
+}
 
 void Switch::setLogStream(std::ostream* os) {
     logStream_ = os;
@@ -28,68 +37,225 @@ void Switch::setLogStream(std::ostream* os) {
 }
 
 void Switch::setLogFile(const std::string& path) {
+    // the switch log is header and summaries only, so every level but none keeps it
+    if (cfg_.logLevel == "none") return;
     logFile_.open(path);
 }
 
-void Switch::generateAndRouteInitialQueue(std::mt19937& rng) {
-    std::uniform_int_distribution<int> svc(cfg_.minServiceTime, cfg_.maxServiceTime);
-    std::uniform_int_distribution<int> type(0, 1);
-    for (int i = 0; i < cfg_.initialQueueSize; ++i) {
-        char jobType = type(rng) ? 'S' : 'P';
-        Request r(randomIp(rng), randomIp(rng), svc(rng), jobType, 0, nextRequestId_++);
-        if (ipBlocker_.isBlocked(r.ipIn)) {
-            totalBlocked_++;
-            continue;
+bool Switch::openTrace(const std::string& path) {
+    trace_ = std::make_unique<TraceReader>();
+    return trace_->open(path);
+}
+
+void Switch::generateAndRouteInitialQueue() {
+    // in chunks, so a large initial queue is never held twice
+    if (trace_) {
+        for (const TraceRecord* r = trace_->peek(); r && r->arrival <= 0; r = trace_->peek()) {
+            arrivals_.clear();
+            takeTraceArrivals(0, static_cast<size_t>(kTraceChunk), arrivals_);
+            for (const Request& a : arrivals_) route(a);
         }
-        if (jobType == 'S')
-            lbStreaming_.enqueueRequest(r);
-        else
-            lbProcessing_.enqueueRequest(r);
+        return;
     }
+    if (cfg_.initialQueueSize <= 0) return;
+    workload_.generate(static_cast<uint64_t>(nextRequestId_), static_cast<size_t>(cfg_.initialQueueSize), ipBlocker_,
+                       batch_, [&](const Workload::Batch& b) {
+        for (size_t i = 0; i < b.size(); ++i) {
+            int id = nextRequestId_++;
+            if (b.isBlocked(i)) totalBlocked_++;
+            else route(Request(b.ipIn[i], b.ipOut[i], b.serviceTime[i], b.jobType[i], 0, id));
+        }
+    });
 }
 
-void Switch::generateAndRouteOneCycle(std::mt19937& rng, int currentTime) {
-    std::uniform_int_distribution<int> percent(0, 99);
-    std::uniform_int_distribution<int> svc(cfg_.minServiceTime, cfg_.maxServiceTime);
-    std::uniform_int_distribution<int> type(0, 1);
-    if (percent(rng) >= cfg_.newRequestProbabilityPercent) return;
-    char jobType = type(rng) ? 'S' : 'P';
-    Request r(randomIp(rng), randomIp(rng), svc(rng), jobType, currentTime, nextRequestId_++);
-    if (ipBlocker_.isBlocked(r.ipIn)) {
-        totalBlocked_++;
-        return;
+void Switch::drawArrivals(int count, int currentTime, std::vector<Request>& out) {
+    if (count <= 0) return;
+    workload_.generate(static_cast<uint64_t>(nextRequestId_), static_cast<size_t>(count), ipBlocker_, batch_,
+                       [&](const Workload::Batch& b) {
+        for (size_t i = 0; i < b.size(); ++i) {
+            int id = nextRequestId_++;
+            if (b.isBlocked(i)) totalBlocked_++;
+            else out.push_back(Request(b.ipIn[i], b.ipOut[i], b.serviceTime[i], b.jobType[i], currentTime, id));
+        }
+    });
+}
+
+void Switch::takeTraceArrivals(int cycle, size_t limit, std::vector<Request>& out) {
+    for (const TraceRecord* r = trace_->peek(); r && r->arrival <= cycle && limit > 0; r = trace_->peek(), --limit) {
+        int id = nextRequestId_++;
+        if (ipBlocker_.isBlocked(r->ipIn)) totalBlocked_++;
+        else out.push_back(Request(r->ipIn, r->ipOut, r->serviceTime, r->jobType, r->arrival, id));
+        trace_->pop();
     }
-    if (jobType == 'S')
+}
+
+int Switch::nextArrival(int from) {
+    if (!trace_) return workload_.nextArrival(from);
+    const TraceRecord* r = trace_->peek();
+    return r && r->arrival < cfg_.runTime ? r->arrival : cfg_.runTime;
+}
+
+void Switch::takeArrivals(int currentTime) {
+    arrivals_.clear();
+    if (trace_) takeTraceArrivals(currentTime, static_cast<size_t>(-1), arrivals_);
+    else drawArrivals(workload_.arrivals(), currentTime, arrivals_);
+}
+
+void Switch::route(const Request& r) {
+    if (r.jobType == 'S')
         lbStreaming_.enqueueRequest(r);
     else
         lbProcessing_.enqueueRequest(r);
 }
 
+void Switch::runSerial() {
+    // arrivals are drawn ahead, so both engines see the same arrivals
+    int nextArrival = this->nextArrival(0);
+    if (cfg_.engine == "event") {
+        // jump to the next arrival or the next cycle at which either LB can change
+        int t = 0;
+        while (t < cfg_.runTime) {
+            if (t == nextArrival) {
+                sampleThrough(t - 1);
+                lbStreaming_.skipTo(t);
+                lbProcessing_.skipTo(t);
+                takeArrivals(t);
+                for (const Request& r : arrivals_) route(r);
+                nextArrival = this->nextArrival(t + 1);
+            }
+            lbStreaming_.runOneCycleAt(t);
+            lbProcessing_.runOneCycleAt(t);
+            t = std::min({nextArrival, lbStreaming_.nextEventTime(), lbProcessing_.nextEventTime()});
+        }
+        lbStreaming_.skipTo(cfg_.runTime);
+        lbProcessing_.skipTo(cfg_.runTime);
+    } else {
+        for (int t = 0; t < cfg_.runTime; ++t) {
+            if (metrics_.nextSample() < t) sampleThrough(t - 1);
+            if (t == nextArrival) {
+                takeArrivals(t);
+                for (const Request& r : arrivals_) route(r);
+                nextArrival = this->nextArrival(t + 1);
+            }
+            lbStreaming_.runOneCycleAt(t);
+            lbProcessing_.runOneCycleAt(t);
+        }
+    }
+}
+
+void Switch::runParallel() {
+    SpscRequestRing toStreaming(kLaneRingSize);
+    SpscRequestRing toProcessing(kLaneRingSize);
+    watermark_.store(0, std::memory_order_relaxed);
+    std::thread streaming([&] { runLane(lbStreaming_, toStreaming); });
+    std::thread processing([&] { runLane(lbProcessing_, toProcessing); });
+
+    // the switch only draws arrivals, the same draws the serial loop makes, so both
+    // modes route the same reqs
+    int published = 0;
+    for (int t = nextArrival(0); t < cfg_.runTime; t = nextArrival(t + 1)) {
+        if (t - published >= kEpochCycles) {
+            published = t;
+            watermark_.store(published, std::memory_order_release);
+        }
+        sampleThrough(t - 1);
+        takeArrivals(t);
+        for (const Request& r : arrivals_) {
+            SpscRequestRing& ring = r.jobType == 'S' ? toStreaming : toProcessing;
+            if (!ring.try_push(r)) {
+                // lane is behind: let it run every cycle before this one so it can drain
+                published = t;
+                watermark_.store(published, std::memory_order_release);
+                while (!ring.try_push(r)) std::this_thread::yield();
+            }
+        }
+    }
+    watermark_.store(cfg_.runTime, std::memory_order_release);
+    streaming.join();
+    processing.join();
+}
+
+void Switch::runLane(LoadBalancer& lb, SpscRequestRing& ring) {
+    bool event = cfg_.engine == "event";
+    int t = 0;
+    for (;;) {
+        // run cycle t once every arrival before and at it has been pushed; a pushed
+        // arrival earlier than the planned cycle (event engine) moves t back to it.
+        // The watermark is read first so the ring holds everything it covers. An idle
+        // LB plans runTime, so it only finishes after the switch has pushed everything.
+        for (;;) {
+            int w = watermark_.load(std::memory_order_acquire);
+            const Request* r = ring.peek();
+            if (r && r->arrivalTime < t) t = r->arrivalTime;
+            if (w > t || w == cfg_.runTime) break;
+            if (r && r->arrivalTime == t) {
+                // more arrivals at t than the ring holds: the switch waits on a full ring,
+                // so queue what it has pushed now (nothing earlier can follow) and run t later
+                takeLaneArrivals(lb, ring, t);
+                continue;
+            }
+            std::this_thread::yield();
+        }
+        if (t >= cfg_.runTime) break;
+        takeLaneArrivals(lb, ring, t);
+        lb.runOneCycleAt(t);
+        t = event ? lb.nextEventTime() : t + 1;
+    }
+    lb.skipTo(cfg_.runTime);
+}
+
+void Switch::sampleThrough(int cycle) {
+    // the switch only blocks at arrivals, so sampling before each one is exact
+    while (metrics_.nextSample() <= cycle) metrics_.record(0, 0, 0, 0, 0, totalBlocked_);
+}
+
+bool Switch::writeMetrics(const std::string& path) const {
+    MetricsFormat format = MetricsFormat::Csv;
+    parseMetricsFormat(cfg_.metricsFormat, format);
+    MetricsSeries combined = metrics_;
+    combined.accumulate(lbStreaming_.getMetricsSeries());
+    combined.accumulate(lbProcessing_.getMetricsSeries());
+    return MetricsSeries::writeFile(path, format, {{"switch", &combined},
+                                                   {"streaming", &lbStreaming_.getMetricsSeries()},
+                                                   {"processing", &lbProcessing_.getMetricsSeries()}});
+}
+
 void Switch::runSimulation() {
     std::random_device rd;
     unsigned int seed = cfg_.seed != 0 ? cfg_.seed : static_cast<unsigned int>(rd());
-    std::mt19937 rng(seed);
+    workload_.seed(seed);
+    lbStreaming_.seed(seed);
+    lbProcessing_.seed(seed);
 
-    generateAndRouteInitialQueue(rng);
+    generateAndRouteInitialQueue();
+    lbStreaming_.markStartingQueue();
+    lbProcessing_.markStartingQueue();
 
+    AdmissionControl admission(cfg_);
     if (logFile_.is_open()) {
         logFile_ << "Switch mode: Streaming + Processing load balancers\n";
         logFile_ << "RunTime: " << cfg_.runTime << " cycles\n";
-        logFile_ << "Initial queue: " << cfg_.initialQueueSize << " (routed by job type S/P)\n";
+        if (trace_)
+            logFile_ << "Trace: " << cfg_.traceFile << (trace_->binary() ? " (binary)" : " (JSONL)") << "\n";
+        else
+            logFile_ << "Initial queue: " << cfg_.initialQueueSize << " (routed by job type S/P)\n";
         logFile_ << "Streaming LB starting queue: " << lbStreaming_.getQueueSize() << "\n";
         logFile_ << "Processing LB starting queue: " << lbProcessing_.getQueueSize() << "\n";
         logFile_ << "Task time range: [" << cfg_.minServiceTime << ", " << cfg_.maxServiceTime << "]\n";
+        if (!workload_.isDefault() && !trace_) logFile_ << "Workload: " << workload_.describe() << "\n";
+        if (admission.enabled()) logFile_ << "Admission (each LB): " << admission.describe() << "\n";
         logFile_ << "Seed: " << seed << "\n";
         logFile_ << "Total blocked (at switch): " << totalBlocked_ << "\n";
         logFile_ << "---\n";
         logFile_.flush();
     }
 
-    for (int t = 0; t < cfg_.runTime; ++t) {
-        generateAndRouteOneCycle(rng, t);
-        lbStreaming_.runOneCycleAt(t);
-        lbProcessing_.runOneCycleAt(t);
-    }
+    // lanes spin while they wait, so they only pay off with a core each
+    if (cfg_.parallelSwitch && std::thread::hardware_concurrency() > 1)
+        runParallel();
+    else
+        runSerial();
+    sampleThrough(cfg_.runTime - 1);
 
     if (logFile_.is_open()) {
         logFile_ << "---\nCOMBINED SUMMARY\n---\n";
@@ -98,6 +264,23 @@ void Switch::runSimulation() {
                  << " queue: " << lbStreaming_.getQueueSize() << "\n";
         logFile_ << "Processing LB completed: " << lbProcessing_.getTotalCompleted()
                  << " queue: " << lbProcessing_.getQueueSize() << "\n";
+        LatencyHistogram wait = lbStreaming_.getWaitHistogram();
+        wait.merge(lbProcessing_.getWaitHistogram());
+        LatencyHistogram sojourn = lbStreaming_.getSojournHistogram();
+        sojourn.merge(lbProcessing_.getSojournHistogram());
+        LoadBalancer::Metrics ms = lbStreaming_.getMetrics();
+        LoadBalancer::Metrics mp = lbProcessing_.getMetrics();
+        if (admission.enabled()) logFile_ << "Total shed (both LBs): " << ms.rejected + mp.rejected << "\n";
+        long long serverCycles = ms.serverCycles + mp.serverCycles;
+        long long busyCycles = ms.busyCycles + mp.busyCycles;
+        logFile_ << "Combined server-cycles provisioned: " << serverCycles << " busy: " << busyCycles << " ("
+                 << std::fixed << std::setprecision(1) << (serverCycles > 0 ? 100.0 * busyCycles / serverCycles : 0)
+                 << "%)\n";
+        logFile_ << "Combined wait time (cycles): ";
+        wait.writeTo(logFile_);
+        logFile_ << "\nCombined sojourn time (cycles): ";
+        sojourn.writeTo(logFile_);
+        logFile_ << "\n";
         logFile_ << "\n";
         lbStreaming_.writeSummaryTo(logFile_, "Streaming");
         logFile_ << "\n";
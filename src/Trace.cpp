@@ -0,0 +1,307 @@
+/**
+ * @file Trace.cpp
+ * @brief Streaming JSONL / binary trace reader and binary trace writer.
+ */
+
+#include "Trace.h"
+#include <cstring>
+#include <string_view>
+
+namespace {
+
+constexpr size_t kBufferSize = size_t{1} << 20;  /**< read buffer; also the longest JSONL line */
+constexpr size_t kMaxBinaryRecord = 10 + 4 + 4 + 10;
+constexpr size_t kWriteFlush = size_t{1} << 20;
+
+void putVarint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out += static_cast<char>((v & 0x7F) | 0x80);
+        v >>= 7;
+    }
+    out += static_cast<char>(v);
+}
+
+bool getVarint(const char*& p, const char* end, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (p == end) return false;
+        uint8_t byte = static_cast<uint8_t>(*p++);
+        v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+void putU32(std::string& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) out += static_cast<char>((v >> (8 * i)) & 0xFF);
+}
+
+uint32_t getU32(const char* p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(static_cast<uint8_t>(p[i])) << (8 * i);
+    return v;
+}
+
+void appendUInt(std::string& out, uint64_t v) {
+    char tmp[24];
+    char* p = tmp + sizeof(tmp);
+    do {
+        *--p = static_cast<char>('0' + v % 10);
+        v /= 10;
+    } while (v);
+    out.append(p, static_cast<size_t>(tmp + sizeof(tmp) - p));
+}
+
+void appendIp(std::string& out, uint32_t ip) {
+    out += '"';
+    for (int i = 3; i >= 0; --i) {
+        appendUInt(out, (ip >> (8 * i)) & 0xFF);
+        if (i) out += '.';
+    }
+    out += '"';
+}
+
+void skipSpace(const char*& p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+}
+
+/** Unsigned decimal integer up to max */
+bool parseUInt(const char*& p, const char* end, uint64_t max, uint64_t& v) {
+    if (p == end || *p < '0' || *p > '9') return false;
+    v = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        v = v * 10 + static_cast<uint64_t>(*p++ - '0');
+        if (v > max) return false;
+    }
+    return true;
+}
+
+/** "a.b.c.d" (quotes included) or a bare integer */
+bool parseIpValue(const char*& p, const char* end, uint32_t& ip) {
+    uint64_t v;
+    if (p < end && *p != '"') {
+        if (!parseUInt(p, end, 0xFFFFFFFFull, v)) return false;
+        ip = static_cast<uint32_t>(v);
+        return true;
+    }
+    ++p;
+    ip = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (i && (p == end || *p++ != '.')) return false;
+        if (!parseUInt(p, end, 255, v)) return false;
+        ip = (ip << 8) | static_cast<uint32_t>(v);
+    }
+    return p < end && *p++ == '"';
+}
+
+/** Skip a string, number or literal value of a key we do not use */
+bool skipValue(const char*& p, const char* end) {
+    if (p < end && *p == '"') {
+        for (++p; p < end; ++p) {
+            if (*p == '\\') ++p;
+            else if (*p == '"') return ++p, true;
+        }
+        return false;
+    }
+    const char* start = p;
+    while (p < end && *p != ',' && *p != '}' && *p != ' ' && *p != '\t') {
+        if (*p == '{' || *p == '[') return false;  // records are flat
+        ++p;
+    }
+    return p > start;
+}
+
+} // namespace
+
+void formatTraceJson(const TraceRecord& r, std::string& out) {
+    out += "{\"arrival\":";
+    appendUInt(out, static_cast<uint64_t>(r.arrival));
+    out += ",\"ipIn\":";
+    appendIp(out, r.ipIn);
+    out += ",\"ipOut\":";
+    appendIp(out, r.ipOut);
+    out += ",\"serviceTime\":";
+    appendUInt(out, static_cast<uint64_t>(r.serviceTime));
+    out += ",\"jobType\":\"";
+    out += r.jobType;
+    out += "\"}\n";
+}
+
+bool TraceReader::open(const std::string& path) {
+    in_.open(path, std::ios::binary);
+    if (!in_) {
+        error_ = "cannot read " + path;
+        return false;
+    }
+    buf_.resize(kBufferSize);
+    fill();
+    if (end_ >= sizeof(kTraceMagic) && std::memcmp(buf_.data(), kTraceMagic, sizeof(kTraceMagic)) == 0) {
+        if (end_ < sizeof(kTraceMagic) + 1 || static_cast<uint8_t>(buf_[sizeof(kTraceMagic)]) != kTraceVersion) {
+            error_ = "unsupported binary trace version";
+            return false;
+        }
+        binary_ = true;
+        pos_ = sizeof(kTraceMagic) + 1;
+    }
+    return true;
+}
+
+bool TraceReader::fill() {
+    if (pos_ > 0) {
+        std::memmove(buf_.data(), buf_.data() + pos_, end_ - pos_);
+        end_ -= pos_;
+        pos_ = 0;
+    }
+    if (eof_ || end_ == buf_.size()) return false;
+    in_.read(buf_.data() + end_, static_cast<std::streamsize>(buf_.size() - end_));
+    size_t got = static_cast<size_t>(in_.gcount());
+    end_ += got;
+    if (got == 0 || !in_) eof_ = true;
+    return got > 0;
+}
+
+void TraceReader::fail(const std::string& what) {
+    error_ = (binary_ ? "record " + std::to_string(count_ + 1) : "line " + std::to_string(line_)) + ": " + what;
+    done_ = true;
+    have_ = false;
+}
+
+void TraceReader::advance() {
+    if (binary_) {
+        if (end_ - pos_ < kMaxBinaryRecord) fill();
+        if (pos_ == end_) {
+            done_ = true;
+            return;
+        }
+        const char* p = buf_.data() + pos_;
+        const char* end = buf_.data() + end_;
+        uint64_t delta, svc;
+        if (!getVarint(p, end, delta) || end - p < 8) return fail("truncated");
+        uint32_t ipIn = getU32(p);
+        uint32_t ipOut = getU32(p + 4);
+        p += 8;
+        if (!getVarint(p, end, svc)) return fail("truncated");
+        if (delta > static_cast<uint64_t>(INT32_MAX - lastArrival_) || (svc >> 1) < 1 || (svc >> 1) > INT32_MAX)
+            return fail("corrupt");
+        lastArrival_ += static_cast<int32_t>(delta);
+        cur_.arrival = lastArrival_;
+        cur_.ipIn = ipIn;
+        cur_.ipOut = ipOut;
+        cur_.serviceTime = static_cast<int32_t>(svc >> 1);
+        cur_.jobType = (svc & 1) ? 'S' : 'P';
+        pos_ = static_cast<size_t>(p - buf_.data());
+        have_ = true;
+        count_++;
+        return;
+    }
+    for (;;) {
+        const char* p = buf_.data() + pos_;
+        const char* end = buf_.data() + end_;
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        if (!nl) {
+            if (!eof_) {
+                if (pos_ == 0 && end_ == buf_.size()) {
+                    line_++;
+                    return fail("line longer than " + std::to_string(buf_.size()) + " bytes");
+                }
+                fill();
+                continue;
+            }
+            if (p == end) {
+                done_ = true;
+                return;
+            }
+            nl = end;  // last line has no newline
+        }
+        line_++;
+        pos_ = static_cast<size_t>(nl - buf_.data()) + (nl < end ? 1 : 0);
+        const char* q = p;
+        skipSpace(q, nl);
+        if (q == nl) continue;
+        parseJson(q, nl);
+        return;
+    }
+}
+
+bool TraceReader::parseJson(const char* p, const char* end) {
+    TraceRecord r;
+    bool hasArrival = false, hasService = false, hasJob = false;
+    if (*p++ != '{') return fail("expected a JSON object"), false;
+    skipSpace(p, end);
+    while (p < end && *p != '}') {
+        if (*p != '"') return fail("expected a key"), false;
+        const char* key = ++p;
+        while (p < end && *p != '"') ++p;
+        if (p == end) return fail("unterminated key"), false;
+        std::string_view name(key, static_cast<size_t>(p - key));
+        ++p;
+        skipSpace(p, end);
+        if (p == end || *p++ != ':') return fail("expected ':' after \"" + std::string(name) + "\""), false;
+        skipSpace(p, end);
+        uint64_t v;
+        bool ok;
+        if (name == "arrival" || name == "arrivalTime") {
+            ok = parseUInt(p, end, INT32_MAX, v);
+            r.arrival = static_cast<int32_t>(v);
+            hasArrival = true;
+        } else if (name == "serviceTime") {
+            ok = parseUInt(p, end, INT32_MAX, v) && v >= 1;
+            r.serviceTime = static_cast<int32_t>(v);
+            hasService = true;
+        } else if (name == "ipIn") {
+            ok = parseIpValue(p, end, r.ipIn);
+        } else if (name == "ipOut") {
+            ok = parseIpValue(p, end, r.ipOut);
+        } else if (name == "jobType") {
+            ok = end - p >= 3 && p[0] == '"' && (p[1] == 'S' || p[1] == 'P') && p[2] == '"';
+            if (ok) r.jobType = p[1];
+            p += 3;
+            hasJob = true;
+        } else {
+            ok = skipValue(p, end);
+        }
+        if (!ok) return fail("bad value for \"" + std::string(name) + "\""), false;
+        skipSpace(p, end);
+        if (p < end && *p == ',') {
+            ++p;
+            skipSpace(p, end);
+        }
+    }
+    if (p == end) return fail("unterminated object"), false;
+    if (!hasArrival || !hasService || !hasJob) return fail("arrival, serviceTime and jobType are required"), false;
+    if (r.arrival < lastArrival_)
+        return fail("arrival " + std::to_string(r.arrival) + " is before " + std::to_string(lastArrival_)), false;
+    lastArrival_ = r.arrival;
+    cur_ = r;
+    have_ = true;
+    count_++;
+    return true;
+}
+
+bool TraceWriter::open(const std::string& path) {
+    out_.open(path, std::ios::binary);
+    if (!out_) return false;
+    buf_.assign(kTraceMagic, sizeof(kTraceMagic));
+    buf_ += static_cast<char>(kTraceVersion);
+    lastArrival_ = 0;
+    return true;
+}
+
+void TraceWriter::write(const TraceRecord& r) {
+    putVarint(buf_, static_cast<uint64_t>(r.arrival - lastArrival_));
+    lastArrival_ = r.arrival;
+    putU32(buf_, r.ipIn);
+    putU32(buf_, r.ipOut);
+    putVarint(buf_, (static_cast<uint64_t>(r.serviceTime) << 1) | (r.jobType == 'S' ? 1u : 0u));
+    if (buf_.size() >= kWriteFlush) {
+        out_.write(buf_.data(), static_cast<std::streamsize>(buf_.size()));
+        buf_.clear();
+    }
+}
+
+bool TraceWriter::close() {
+    out_.write(buf_.data(), static_cast<std::streamsize>(buf_.size()));
+    buf_.clear();
+    out_.close();
+    return !out_.fail();
+}
@@ -4,16 +4,63 @@
  */
 
 #include "WebServer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 
-WebServer::WebServer(int id) : id_(id) {}
+bool parseServerClass(const std::string& spec, ServerClass& cls) {
+    ServerClass c;
+    size_t colon = spec.find(':');
+    if (colon == 0 || colon == std::string::npos) return false;
+    c.name = spec.substr(0, colon);
+    // count[:slots[:speed]]
+    const char* p = spec.c_str() + colon + 1;
+    char* end = nullptr;
+    long count = std::strtol(p, &end, 10);
+    if (end == p || count < 0) return false;
+    c.count = static_cast<int>(count);
+    if (*end == ':') {
+        p = end + 1;
+        long slots = std::strtol(p, &end, 10);
+        if (end == p || slots < 1) return false;
+        c.slots = static_cast<int>(slots);
+        if (*end == ':') {
+            p = end + 1;
+            c.speed = std::strtod(p, &end);
+            if (end == p || !(c.speed > 0)) return false;
+        }
+    }
+    if (*end != '\0') return false;
+    cls = c;
+    return true;
+}
+
+WebServer::WebServer(int id, int startTime, int slots, double speed, int cls)
+    : id_(id), speed_(speed > 0 ? speed : 1.0), cls_(cls), slot_(static_cast<size_t>(std::max(slots, 1))),
+      since_(startTime), inactive_(startTime) {
+    for (int i = this->slots() - 1; i >= 0; --i) free_.push_back(i);
+}
 
 bool WebServer::isBusy(int currentTime) const {
-    return active_ && bU_ > currentTime;
+    if (state_ == State::Inactive) return false;
+    for (const Slot& s : slot_)
+        if (s.until > currentTime) return true;
+    return false;
+}
+
+int WebServer::serviceCycles(const Request& r) const {
+    if (speed_ == 1.0) return r.serviceTime;
+    return std::max(1, static_cast<int>(std::ceil(r.serviceTime / speed_)));
 }
 
-void WebServer::assignRequest(const Request& r, int currentTime) {
-    cR_ = r;
-    bU_ = currentTime + r.serviceTime;
+int WebServer::assignRequest(RequestHandle h, const Request& r, int currentTime) {
+    int i = free_.back();
+    free_.pop_back();
+    Slot& s = slot_[static_cast<size_t>(i)];
+    s.req = h;
+    s.start = currentTime;
+    s.until = currentTime + serviceCycles(r);
+    return i;
 }
 
 void WebServer::tick(int currentTime) {
@@ -24,19 +71,52 @@ int WebServer::getId() const {
     return id_;
 }
 
+int WebServer::busyUntil() const {
+    int first = -1;
+    for (const Slot& s : slot_)
+        if (s.until >= 0 && (first < 0 || s.until < first)) first = s.until;
+    return first;
+}
+
 bool WebServer::active() const {
-    return active_;
+    return state_ != State::Inactive;
+}
+
+void WebServer::setState(State s, int currentTime) {
+    if (s == state_) return;
+    long long open = currentTime > since_ ? currentTime - since_ : 0;
+    if (state_ == State::Inactive) inactive_ += open;
+    else if (state_ == State::WarmingUp) warming_ += open;
+    else up_ += open;
+    since_ = currentTime;
+    state_ = s;
 }
 
-void WebServer::setActive(bool a) {
-    active_ = a;
+WebServer::CycleCounts WebServer::cycleCounts(int now) const {
+    long long open = now > since_ ? now - since_ : 0;
+    long long inactive = inactive_, warming = warming_, up = up_;
+    if (state_ == State::Inactive) inactive += open;
+    else if (state_ == State::WarmingUp) warming += open;
+    else up += open;
+    long long k = slots();
+    CycleCounts c;
+    c.busy = busyDone_;
+    for (const Slot& s : slot_)
+        if (s.until >= 0 && now > s.start) c.busy += std::min(now, s.until) - s.start;
+    c.idle = up * k - c.busy;
+    c.warming = warming * k;
+    c.inactive = inactive * k;
+    return c;
 }
 
-const Request* WebServer::currentRequest() const {
-    if (bU_ < 0) return nullptr;
-    return &cR_;
+RequestHandle WebServer::currentRequest(int slot) const {
+    return slot_[static_cast<size_t>(slot)].req;
 }
 
-void WebServer::markCompleted() {
-    bU_ = -1;
+void WebServer::markCompleted(int slot) {
+    Slot& s = slot_[static_cast<size_t>(slot)];
+    busyDone_ += s.until - s.start;
+    s.until = -1;
+    s.req = kNoRequest;
+    free_.push_back(slot);
 }
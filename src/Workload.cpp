@@ -0,0 +1,275 @@
+/**
+ * @file Workload.cpp
+ * @brief Implementation of Workload: arrival processes and service-time distributions.
+ */
+
+#include "Workload.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+constexpr double kTwoPi = 6.283185307179586;
+constexpr double kInversionMaxRate = 30.0;  /**< above this, Poisson counts come from std::poisson_distribution */
+constexpr size_t kChunk = size_t{1} << 14;  /**< reqs per filterBatch call, and per thread and round in generate */
+
+// Philox streams: the same key gives unrelated sequences on each
+constexpr uint32_t kRequestStream = 0;  /**< block i = fields of req id i */
+constexpr uint32_t kArrivalStream = 1;  /**< nextArrival draws, in order */
+constexpr uint32_t kCoinStream = 2;     /**< block t = arrivesAt(t) */
+
+/** 32 random bits to [0, range) */
+uint32_t scaleBits(uint32_t bits, uint64_t range) {
+    return static_cast<uint32_t>((bits * range) >> 32);
+}
+
+} // namespace
+
+bool parseArrivalProcess(const std::string& s, ArrivalProcess& p) {
+    if (s == "bernoulli") p = ArrivalProcess::Bernoulli;
+    else if (s == "poisson") p = ArrivalProcess::Poisson;
+    else if (s == "mmpp") p = ArrivalProcess::Mmpp;
+    else if (s == "diurnal") p = ArrivalProcess::Diurnal;
+    else return false;
+    return true;
+}
+
+bool parseServiceDistribution(const std::string& s, ServiceDistribution& d) {
+    if (s == "uniform") d = ServiceDistribution::Uniform;
+    else if (s == "exponential") d = ServiceDistribution::Exponential;
+    else if (s == "lognormal") d = ServiceDistribution::Lognormal;
+    else if (s == "pareto") d = ServiceDistribution::Pareto;
+    else return false;
+    return true;
+}
+
+Workload::Workload(const Config& cfg)
+    : runTime_(cfg.runTime), threads_(cfg.generatorThreads), percent_(cfg.newRequestProbabilityPercent),
+      minService_(cfg.minServiceTime), maxService_(std::max(cfg.maxServiceTime, cfg.minServiceTime)) {
+    parseArrivalProcess(cfg.arrivalProcess, arrival_);
+    parseServiceDistribution(cfg.serviceDistribution, service_);
+    rate_ = cfg.arrivalRate > 0 ? cfg.arrivalRate : std::max(percent_, 0) / 100.0;
+    burstRate_ = cfg.burstRate > 0 ? cfg.burstRate : 10 * rate_;
+    calmCycles_ = std::max(cfg.calmCycles, 1);
+    burstCycles_ = std::max(cfg.burstCycles, 1);
+    period_ = cfg.diurnalPeriod > 0 ? cfg.diurnalPeriod : std::max(runTime_, 1);
+    amplitude_ = std::min(std::max(cfg.diurnalAmplitudePercent, 0), 100) / 100.0;
+    mean_ = cfg.serviceMean > 0 ? cfg.serviceMean : (minService_ + maxService_) / 2.0;
+    sigma_ = cfg.serviceSigma > 0 ? cfg.serviceSigma : 1.0;
+    alpha_ = cfg.paretoAlpha > 0 ? cfg.paretoAlpha : 1.5;
+    // scale that gives the configured mean; an infinite-mean tail starts at minServiceTime
+    paretoScale_ = alpha_ > 1 ? mean_ * (alpha_ - 1) / alpha_ : std::max(minService_, 1);
+    seed(cfg.seed);
+}
+
+void Workload::seed(unsigned int seed) {
+    key_ = seed;
+    stream_ = PhiloxStream(key_, kArrivalStream);
+    count_ = 0;
+    burst_ = true;
+    stateEnd_ = 0;
+}
+
+int Workload::positivePoisson(double rate) {
+    if (rate > kInversionMaxRate) {
+        std::poisson_distribution<int> d(rate);
+        int k;
+        do k = d(stream_);
+        while (k == 0);
+        return k;
+    }
+    // invert the CDF above P(0), so one draw gives a count of at least 1
+    double p = std::exp(-rate);
+    double target = p - std::expm1(-rate) * uniform();
+    double cdf = p;
+    int k = 0;
+    while (cdf < target && k < 1000) {
+        ++k;
+        p *= rate / k;
+        cdf += p;
+    }
+    return std::max(k, 1);
+}
+
+int Workload::nextPoisson(double from, double end, double rate) {
+    if (rate <= 0 || from >= end) return -1;
+    // cycles with no arrival before the next one: P(gap >= k) = exp(-rate k)
+    double t = from + std::floor(-std::log(uniform()) / rate);
+    if (t >= end) return -1;
+    count_ = positivePoisson(rate);
+    return static_cast<int>(t);
+}
+
+int Workload::nextArrival(int from) {
+    count_ = 0;
+    switch (arrival_) {
+    case ArrivalProcess::Bernoulli: {
+        if (percent_ <= 0 || from >= runTime_) return runTime_;
+        double t = from;
+        // cycles without an arrival before the next one are geometric: one draw per arrival
+        if (percent_ < 100) t += std::floor(std::log(uniform()) / std::log1p(-percent_ / 100.0));
+        if (t >= runTime_) return runTime_;
+        count_ = 1;
+        return static_cast<int>(t);
+    }
+    case ArrivalProcess::Poisson: {
+        int t = nextPoisson(from, runTime_, rate_);
+        return t < 0 ? runTime_ : t;
+    }
+    case ArrivalProcess::Mmpp: {
+        // spells are geometric, so a spell cut short at from loses nothing
+        double t = from;
+        while (t < runTime_) {
+            if (t >= stateEnd_) {
+                burst_ = !burst_;
+                double mean = burst_ ? burstCycles_ : calmCycles_;
+                double len = mean > 1 ? 1 + std::floor(std::log(uniform()) / std::log1p(-1 / mean)) : 1;
+                stateEnd_ += len;
+                continue;
+            }
+            int a = nextPoisson(t, std::min<double>(stateEnd_, runTime_), burst_ ? burstRate_ : rate_);
+            if (a >= 0) return a;
+            t = stateEnd_;
+        }
+        return runTime_;
+    }
+    case ArrivalProcess::Diurnal: {
+        // thin a Poisson process at the peak rate down to the rate of each cycle
+        double peak = rate_ * (1 + amplitude_);
+        double t = from;
+        while (t < runTime_) {
+            int a = nextPoisson(t, runTime_, peak);
+            if (a < 0) break;
+            double rate = rate_ * (1 + amplitude_ * std::sin(kTwoPi * a / period_));
+            std::binomial_distribution<int> keep(count_, std::min(rate / peak, 1.0));
+            count_ = keep(stream_);
+            if (count_ > 0) return a;
+            t = a + 1;
+        }
+        count_ = 0;
+        return runTime_;
+    }
+    }
+    return runTime_;
+}
+
+bool Workload::arrivesAt(int cycle) const {
+    uint32_t bits = philox4x32(key_, static_cast<uint64_t>(cycle), kCoinStream).w[0];
+    return static_cast<int>(scaleBits(bits, 100)) < percent_;
+}
+
+int Workload::clampService(double x) const {
+    x = std::min(std::max(x, static_cast<double>(minService_)), static_cast<double>(maxService_));
+    return std::max(static_cast<int>(std::lround(x)), 1);
+}
+
+void Workload::draw(uint64_t firstId, size_t n, Batch& out) const {
+    out.ipIn.resize(n);
+    out.ipOut.resize(n);
+    out.serviceTime.resize(n);
+    out.jobType.resize(n);
+    out.bits.resize(2 * n);
+    // one block per req; this loop has no branches, so it vectorizes
+    for (size_t i = 0; i < n; ++i) {
+        PhiloxBlock b = philox4x32(key_, firstId + i, kRequestStream);
+        out.ipIn[i] = b.w[0];
+        out.ipOut[i] = b.w[1];
+        out.bits[2 * i] = b.w[2];
+        out.bits[2 * i + 1] = b.w[3];
+    }
+    for (size_t i = 0; i < n; ++i) out.jobType[i] = (out.bits[2 * i + 1] & 1) ? 'S' : 'P';
+    switch (service_) {
+    case ServiceDistribution::Uniform: {
+        uint64_t range = static_cast<uint64_t>(maxService_ - minService_) + 1;
+        for (size_t i = 0; i < n; ++i) out.serviceTime[i] = minService_ + static_cast<int>(scaleBits(out.bits[2 * i], range));
+        break;
+    }
+    case ServiceDistribution::Exponential:
+        for (size_t i = 0; i < n; ++i) out.serviceTime[i] = clampService(-mean_ * std::log(philoxUniform(out.bits[2 * i])));
+        break;
+    case ServiceDistribution::Lognormal: {
+        // Box-Muller; the angle takes the 31 bits the job type leaves
+        double mu = std::log(mean_) - sigma_ * sigma_ / 2;
+        for (size_t i = 0; i < n; ++i) {
+            double r = std::sqrt(-2 * std::log(philoxUniform(out.bits[2 * i])));
+            double a = kTwoPi * ((out.bits[2 * i + 1] >> 1) + 0.5) / 2147483648.0;
+            out.serviceTime[i] = clampService(std::exp(mu + sigma_ * r * std::cos(a)));
+        }
+        break;
+    }
+    case ServiceDistribution::Pareto:
+        for (size_t i = 0; i < n; ++i)
+            out.serviceTime[i] = clampService(paretoScale_ * std::pow(philoxUniform(out.bits[2 * i]), -1 / alpha_));
+        break;
+    }
+}
+
+void Workload::generate(uint64_t firstId, size_t n, const IPBlocker& blocker, Batch& scratch, const ChunkFn& take) const {
+    auto fill = [&](uint64_t first, size_t count, Batch& b) {
+        draw(first, count, b);
+        b.blocked.resize((count + 63) / 64);
+        blocker.filterBatch(b.ipIn.data(), count, b.blocked.data());
+    };
+    size_t threads = threads_ > 0 ? static_cast<size_t>(threads_) : std::thread::hardware_concurrency();
+    threads = std::min(std::max<size_t>(threads, 1), (n + kChunk - 1) / kChunk);
+    if (threads <= 1) {
+        for (size_t done = 0; done < n; done += kChunk) {
+            fill(firstId + done, std::min(kChunk, n - done), scratch);
+            take(scratch);
+        }
+        return;
+    }
+    // rounds of one chunk per thread; chunks are handed over in id order
+    std::vector<Batch> chunks(threads);
+    std::vector<std::thread> pool;
+    for (size_t done = 0; done < n; done += threads * kChunk) {
+        size_t used = std::min(threads, (n - done + kChunk - 1) / kChunk);
+        pool.clear();
+        for (size_t t = 1; t < used; ++t) {
+            size_t first = done + t * kChunk;
+            pool.emplace_back([&, t, first] { fill(firstId + first, std::min(kChunk, n - first), chunks[t]); });
+        }
+        fill(firstId + done, std::min(kChunk, n - done), chunks[0]);
+        for (std::thread& th : pool) th.join();
+        for (size_t t = 0; t < used; ++t) take(chunks[t]);
+    }
+}
+
+std::string Workload::describe() const {
+    std::ostringstream os;
+    switch (arrival_) {
+    case ArrivalProcess::Bernoulli:
+        os << "bernoulli " << percent_ << "%/cycle";
+        break;
+    case ArrivalProcess::Poisson:
+        os << "poisson " << rate_ << "/cycle";
+        break;
+    case ArrivalProcess::Mmpp:
+        os << "mmpp " << rate_ << "/cycle calm ~" << calmCycles_ << " cycles, " << burstRate_ << "/cycle burst ~"
+           << burstCycles_ << " cycles";
+        break;
+    case ArrivalProcess::Diurnal:
+        os << "diurnal " << rate_ << "/cycle +/-" << amplitude_ * 100 << "% over " << period_ << " cycles";
+        break;
+    }
+    os << "; service ";
+    switch (service_) {
+    case ServiceDistribution::Uniform:
+        os << "uniform";
+        break;
+    case ServiceDistribution::Exponential:
+        os << "exponential mean " << mean_;
+        break;
+    case ServiceDistribution::Lognormal:
+        os << "lognormal mean " << mean_ << " sigma " << sigma_;
+        break;
+    case ServiceDistribution::Pareto:
+        os << "pareto alpha " << alpha_ << " scale " << paretoScale_;
+        break;
+    }
+    os << " in [" << minService_ << ", " << maxService_ << "]";
+    return os.str();
+}
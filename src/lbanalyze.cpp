@@ -0,0 +1,49 @@
+/**
+ * @file lbanalyze.cpp
+ * @brief Summarizes run logs: per-server counts and busy time, scale timeline,
+ *        queue-depth percentiles and blocked counts.
+ * @author Bizaco Load Balancer Project
+ *
+ * Usage: lbanalyze [--jobs N] [--timeline] <log> [log ...]
+ * Text and binary (--log-format=binary) logs are both accepted.
+ */
+
+#include "LogAnalyzer.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    int jobs = 0;
+    bool timeline = false;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) jobs = std::atoi(argv[++i]);
+        else if (std::strncmp(argv[i], "--jobs=", 7) == 0) jobs = std::atoi(argv[i] + 7);
+        else if (std::strcmp(argv[i], "--timeline") == 0) timeline = true;
+        else paths.push_back(argv[i]);
+    }
+    if (paths.empty()) {
+        std::cerr << "Usage: lbanalyze [--jobs N] [--timeline] <log> [log ...]" << std::endl;
+        return 1;
+    }
+
+    LogAnalyzer analyzer(jobs);
+    int status = 0;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        LogStats stats;
+        auto start = std::chrono::steady_clock::now();
+        if (!analyzer.analyzeFile(paths[i], stats)) {
+            std::cerr << "Cannot read log file (or corrupt binary log): " << paths[i] << std::endl;
+            status = 1;
+            continue;
+        }
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (i > 0) std::cout << "\n";
+        LogAnalyzer::writeReport(paths[i], stats, secs, timeline, std::cout);
+    }
+    return status;
+}
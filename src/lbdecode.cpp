@@ -0,0 +1,89 @@
+/**
+ * @file lbdecode.cpp
+ * @brief Turns a binary run log (--log-format=binary) back into the text log.
+ * @author Bizaco Load Balancer Project
+ *
+ * Usage: lbdecode <in.bin> [out.txt] [--config]
+ * Writes to stdout when no output file is given; --config prints the
+ * run config stored in the log header instead of the log.
+ */
+
+#include "LogFormat.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    std::string inPath, outPath;
+    bool configOnly = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--config") == 0) configOnly = true;
+        else if (inPath.empty()) inPath = argv[i];
+        else outPath = argv[i];
+    }
+    if (inPath.empty()) {
+        std::cerr << "Usage: lbdecode <in.bin> [out.txt] [--config]" << std::endl;
+        return 1;
+    }
+
+    std::ifstream in(inPath, std::ios::binary);
+    if (!in) {
+        std::cerr << "Cannot read log file: " << inPath << std::endl;
+        return 1;
+    }
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    FILE* out = stdout;
+    if (!outPath.empty() && !(out = std::fopen(outPath.c_str(), "wb"))) {
+        std::cerr << "Cannot write output file: " << outPath << std::endl;
+        return 1;
+    }
+
+    const char* p = data.data();
+    const char* end = p + data.size();
+    BinaryLogDecoder decoder;
+    if (!decoder.begin(p, end)) {
+        if (decoder.version() == 0)
+            std::cerr << inPath << " is not a binary run log" << std::endl;
+        else
+            std::cerr << inPath << " is binary log format version " << static_cast<int>(decoder.version())
+                      << "; this lbdecode reads versions " << static_cast<int>(kBinaryLogMinVersion) << " to "
+                      << static_cast<int>(kBinaryLogVersion) << std::endl;
+        if (out != stdout) std::fclose(out);
+        return 1;
+    }
+
+    LogRecord r;
+    std::string text;
+    std::string buf;
+    const char* record = p;
+    while (decoder.next(p, end, r, text)) {
+        record = p;
+        if (r.kind == LogKind::Config) {
+            if (configOnly) buf += text;
+        } else if (!configOnly) {
+            if (r.kind == LogKind::Text) buf += text;
+            else formatLogLine(r, buf);
+        }
+        if (buf.size() >= (1u << 20)) {
+            std::fwrite(buf.data(), 1, buf.size(), out);
+            buf.clear();
+        }
+    }
+    std::fwrite(buf.data(), 1, buf.size(), out);
+    bool ok = std::ferror(out) == 0;
+    if (out != stdout) ok = std::fclose(out) == 0 && ok;
+
+    if (record != end) {
+        std::cerr << inPath << ": truncated or corrupt record at byte " << (record - data.data()) << std::endl;
+        return 1;
+    }
+    if (!ok) {
+        std::cerr << "Cannot write output file: " << outPath << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file lbtrace.cpp
+ * @brief Converts a JSONL request trace to the compact binary form, or back.
+ * @author Bizaco Load Balancer Project
+ *
+ * Usage: lbtrace <in> <out>
+ * A JSONL input is written as a binary trace; a binary input is written
+ * back out as JSONL. Both are streamed, so any trace size works.
+ */
+
+#include "Trace.h"
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: lbtrace <in.jsonl|in.bin> <out>" << std::endl;
+        return 1;
+    }
+    std::string inPath = argv[1], outPath = argv[2];
+    TraceReader reader;
+    if (!reader.open(inPath)) {
+        std::cerr << "Cannot read trace " << inPath << ": " << reader.error() << std::endl;
+        return 1;
+    }
+
+    bool ok;
+    if (reader.binary()) {
+        FILE* out = std::fopen(outPath.c_str(), "wb");
+        if (!out) {
+            std::cerr << "Cannot write output file: " << outPath << std::endl;
+            return 1;
+        }
+        std::string buf;
+        for (const TraceRecord* r = reader.peek(); r; r = reader.peek()) {
+            formatTraceJson(*r, buf);
+            reader.pop();
+            if (buf.size() >= (1u << 20)) {
+                std::fwrite(buf.data(), 1, buf.size(), out);
+                buf.clear();
+            }
+        }
+        std::fwrite(buf.data(), 1, buf.size(), out);
+        ok = std::ferror(out) == 0;
+        ok = std::fclose(out) == 0 && ok;
+    } else {
+        TraceWriter writer;
+        if (!writer.open(outPath)) {
+            std::cerr << "Cannot write output file: " << outPath << std::endl;
+            return 1;
+        }
+        for (const TraceRecord* r = reader.peek(); r; r = reader.peek()) {
+            writer.write(*r);
+            reader.pop();
+        }
+        ok = writer.close();
+    }
+
+    if (!reader.error().empty()) {
+        std::cerr << inPath << ": " << reader.error() << " (" << reader.count() << " records converted)" << std::endl;
+        return 1;
+    }
+    if (!ok) {
+        std::cerr << "Cannot write output file: " << outPath << std::endl;
+        return 1;
+    }
+    std::cout << reader.count() << " records: " << (reader.binary() ? "binary -> JSONL" : "JSONL -> binary")
+              << " " << outPath << std::endl;
+    return 0;
+}
@@ -10,6 +10,14 @@
 #include "Config.h"
 #include "LoadBalancer.h"
 #include "Switch.h"
+#include "Sweep.h"
+#include "LogSink.h"
+#include "MetricsSeries.h"
+#include "DispatchPolicy.h"
+#include "WebServer.h"
+#include "Workload.h"
+#include "Admission.h"
+#include "SchedulingQueue.h"
 #include <iostream>
 #include <cstdlib>
 #include <cstring>
@@ -27,6 +35,19 @@ static bool hasSwitchMode(int argc, char* argv[]) {
     return false;
 }
 
+static bool setupBlocker(IPBlocker& blocker, const Config& cfg) {
+    blocker.addBlockedRanges(cfg.blockedRanges);
+    blocker.addAllowedRanges(cfg.allowedRanges);
+    if (cfg.blocklistFile.empty()) return true;
+    size_t loaded = 0;
+    if (!blocker.loadBlocklistFile(cfg.blocklistFile, &loaded)) {
+        std::cerr << "Cannot read blocklist file: " << cfg.blocklistFile << std::endl;
+        return false;
+    }
+    std::cout << "Loaded " << loaded << " prefixes from " << cfg.blocklistFile << std::endl;
+    return true;
+}
+
 int main(int argc, char* argv[]) {
     Config cfg;
     cfg.initialQueueSize = cfg.initialServers * 100;
@@ -38,10 +59,146 @@ int main(int argc, char* argv[]) {
     cfg.applyCommandLine(argc, argv);
 
     bool useSwitch = hasSwitchMode(argc, argv);
+    LogLevel level;
+    if (!parseLogLevel(cfg.logLevel, level)) {
+        std::cerr << "Unknown log level: " << cfg.logLevel << " (use all, scale, summary or none)" << std::endl;
+        return 1;
+    }
+    LogEncoding encoding;
+    if (!parseLogEncoding(cfg.logFormat, encoding)) {
+        std::cerr << "Unknown log format: " << cfg.logFormat << " (use text or binary)" << std::endl;
+        return 1;
+    }
+    if (cfg.engine != "cycle" && cfg.engine != "event") {
+        std::cerr << "Unknown engine: " << cfg.engine << " (use cycle or event)" << std::endl;
+        return 1;
+    }
+    if (cfg.scaler != "threshold" && cfg.scaler != "predictive") {
+        std::cerr << "Unknown scaler: " << cfg.scaler << " (use threshold or predictive)" << std::endl;
+        return 1;
+    }
+    std::unique_ptr<DispatchPolicy> dispatch = makeDispatchPolicy(cfg);
+    if (!dispatch) {
+        std::cerr << "Unknown dispatch policy: " << cfg.dispatch
+                  << " (use lowest-idle, round-robin, least-work, power-of-two or jiq)" << std::endl;
+        return 1;
+    }
+    ArrivalProcess arrivals;
+    if (!parseArrivalProcess(cfg.arrivalProcess, arrivals)) {
+        std::cerr << "Unknown arrival process: " << cfg.arrivalProcess << " (use bernoulli, poisson, mmpp or diurnal)"
+                  << std::endl;
+        return 1;
+    }
+    ServiceDistribution service;
+    if (!parseServiceDistribution(cfg.serviceDistribution, service)) {
+        std::cerr << "Unknown service distribution: " << cfg.serviceDistribution
+                  << " (use uniform, exponential, lognormal or pareto)" << std::endl;
+        return 1;
+    }
+    AdmissionPolicy admission;
+    if (!parseAdmissionPolicy(cfg.admissionPolicy, admission)) {
+        std::cerr << "Unknown admission policy: " << cfg.admissionPolicy << " (use reject-new, drop-oldest or red)"
+                  << std::endl;
+        return 1;
+    }
+    RedSignal redSignal;
+    if (!parseRedSignal(cfg.redSignal, redSignal)) {
+        std::cerr << "Unknown RED signal: " << cfg.redSignal << " (use depth or age)" << std::endl;
+        return 1;
+    }
+    if (admission == AdmissionPolicy::Red && cfg.redMax <= 0 &&
+        (redSignal == RedSignal::Depth ? cfg.maxQueueDepth : cfg.queueTimeout) <= 0) {
+        std::cerr << "--admission red needs redMax, or " << (redSignal == RedSignal::Depth ? "maxQueueDepth" : "queueTimeout")
+                  << " to derive it from" << std::endl;
+        return 1;
+    }
+    QueueDiscipline discipline;
+    if (!parseQueueDiscipline(cfg.queueDiscipline, discipline)) {
+        std::cerr << "Unknown queue discipline: " << cfg.queueDiscipline << " (use fifo, priority, sjf, edf or wfq)"
+                  << std::endl;
+        return 1;
+    }
+    if (cfg.priorityJobType != "S" && cfg.priorityJobType != "P") {
+        std::cerr << "Invalid priorityJobType: " << cfg.priorityJobType << " (use S or P)" << std::endl;
+        return 1;
+    }
+    if (cfg.realtime && discipline != QueueDiscipline::Fifo) {
+        std::cerr << "--realtime serves its lock-free queue in FIFO order; it cannot be combined with --queue-discipline"
+                  << std::endl;
+        return 1;
+    }
+    if (dispatch->usesServerQueues() && discipline != QueueDiscipline::Fifo) {
+        std::cerr << "--dispatch " << cfg.dispatch << " moves reqs to FIFO server queues as they arrive; "
+                  << "--queue-discipline needs lowest-idle or round-robin" << std::endl;
+        return 1;
+    }
+    if (cfg.realtime && AdmissionControl(cfg).enabled()) {
+        std::cerr << "--realtime has its own bounded queue; it cannot be combined with admission control" << std::endl;
+        return 1;
+    }
+    if (cfg.realtime && !Workload(cfg).isDefault()) {
+        std::cerr << "--realtime generates bernoulli arrivals with uniform service times only" << std::endl;
+        return 1;
+    }
+    if (!cfg.serverClasses.empty()) {
+        int classServers = 0;
+        for (const std::string& spec : cfg.serverClasses) {
+            ServerClass c;
+            if (!parseServerClass(spec, c)) {
+                std::cerr << "Invalid server class: " << spec << " (use name:count[:slots[:speed]])" << std::endl;
+                return 1;
+            }
+            classServers += c.count;
+        }
+        if (classServers <= 0) {
+            std::cerr << "Server classes add up to no servers" << std::endl;
+            return 1;
+        }
+        cfg.initialServers = classServers;
+    }
+    MetricsFormat metricsFormat;
+    if (!parseMetricsFormat(cfg.metricsFormat, metricsFormat)) {
+        std::cerr << "Unknown metrics format: " << cfg.metricsFormat << " (use csv or prom)" << std::endl;
+        return 1;
+    }
+    if (!cfg.traceFile.empty() && (cfg.realtime || !cfg.sweepPath.empty())) {
+        std::cerr << "--trace replays a simulated run; it cannot be combined with --realtime or --sweep" << std::endl;
+        return 1;
+    }
+    if (!cfg.sweepPath.empty()) {
+        if (cfg.logPath.empty()) cfg.logPath = "logs/sweep.csv";
+        size_t slash = cfg.logPath.find_last_of("/\\");
+        if (slash != std::string::npos) mkdir(cfg.logPath.substr(0, slash).c_str(), 0755);
+        Sweep sweep(cfg);
+        if (!sweep.loadFromFile(cfg.sweepPath)) {
+            std::cerr << "Cannot read sweep file: " << cfg.sweepPath << std::endl;
+            return 1;
+        }
+        if (!setupBlocker(sweep.getIPBlocker(), sweep.getBaseConfig())) return 1;
+        if (!sweep.run(cfg.sweepThreads, cfg.logPath, &std::cout)) {
+            std::cerr << "Cannot write sweep results: " << cfg.logPath << std::endl;
+            return 1;
+        }
+        std::cout << "Sweep results written to " << cfg.logPath << std::endl;
+        return 0;
+    }
+    if (useSwitch && cfg.realtime) {
+        std::cerr << "--realtime runs a single LB; it cannot be combined with --switch" << std::endl;
+        return 1;
+    }
     if (cfg.logPath.empty())
-        cfg.logPath = useSwitch
+        cfg.logPath = cfg.realtime
+            ? "logs/realtime_" + std::to_string(cfg.threads > 0 ? cfg.threads : cfg.initialServers) + "threads.txt"
+            : useSwitch
             ? "logs/switch_" + std::to_string(cfg.runTime) + "cycles.txt"
-            : "logs/run_log_" + std::to_string(cfg.initialServers) + "servers_" + std::to_string(cfg.runTime) + "cycles.txt";
+            : "logs/run_log_" + std::to_string(cfg.initialServers) + "servers_" + std::to_string(cfg.runTime) + "cycles"
+              + (encoding == LogEncoding::Binary ? ".bin" : ".txt");
+
+    if (cfg.metricsInterval > 0 && cfg.metricsPath.empty()) {
+        size_t dot = cfg.logPath.find_last_of('.');
+        size_t base = dot != std::string::npos && dot > cfg.logPath.find_last_of("/\\") + 1 ? dot : cfg.logPath.size();
+        cfg.metricsPath = cfg.logPath.substr(0, base) + "_metrics" + (metricsFormat == MetricsFormat::Csv ? ".csv" : ".prom");
+    }
 
     size_t slash = cfg.logPath.find_last_of("/\\");
     if (slash != std::string::npos) {
@@ -51,23 +208,48 @@ int main(int argc, char* argv[]) {
 
     if (useSwitch) {
         Switch sw(cfg);
-        for (const auto& range : cfg.blockedRanges){
-            sw.getIPBlocker().addBlockedRange(range);}
+        if (!setupBlocker(sw.getIPBlocker(), cfg)) return 1;
+        if (!cfg.traceFile.empty() && !sw.openTrace(cfg.traceFile)) {
+            std::cerr << "Cannot read trace file: " << cfg.traceFile << " (" << sw.getTrace()->error() << ")" << std::endl;
+            return 1;
+        }
         sw.setLogStream(&std::cout);
         sw.setLogFile(cfg.logPath);
         sw.runSimulation();
+        if (sw.getTrace() && !sw.getTrace()->error().empty()) {
+            std::cerr << "Trace " << cfg.traceFile << ": " << sw.getTrace()->error() << std::endl;
+            return 1;
+        }
+        if (cfg.metricsInterval > 0 && !sw.writeMetrics(cfg.metricsPath)) {
+            std::cerr << "Cannot write metrics file: " << cfg.metricsPath << std::endl;
+            return 1;
+        }
         std::cout << "Switch sim done. Log written to " << cfg.logPath << std::endl;
+        if (cfg.metricsInterval > 0) std::cout << "Metrics written to " << cfg.metricsPath << std::endl;
 
 
 
     } else {
         LoadBalancer lb(cfg);
-        for (const auto& range : cfg.blockedRanges)
-            lb.getIPBlocker().addBlockedRange(range);
+        if (!setupBlocker(lb.getIPBlocker(), cfg)) return 1;
+        if (!cfg.traceFile.empty() && !lb.openTrace(cfg.traceFile)) {
+            std::cerr << "Cannot read trace file: " << cfg.traceFile << " (" << lb.getTrace()->error() << ")" << std::endl;
+            return 1;
+        }
         lb.setLogStream(&std::cout);
         lb.setLogFile(cfg.logPath);
-        lb.runSimulation();
+        if (cfg.realtime) lb.runRealtime();
+        else lb.runSimulation();
+        if (lb.getTrace() && !lb.getTrace()->error().empty()) {
+            std::cerr << "Trace " << cfg.traceFile << ": " << lb.getTrace()->error() << std::endl;
+            return 1;
+        }
+        if (cfg.metricsInterval > 0 && !cfg.realtime && !lb.writeMetrics(cfg.metricsPath)) {
+            std::cerr << "Cannot write metrics file: " << cfg.metricsPath << std::endl;
+            return 1;
+        }
         std::cout << "Sim complete. Log written to " << cfg.logPath << std::endl;
+        if (cfg.metricsInterval > 0 && !cfg.realtime) std::cout << "Metrics written to " << cfg.metricsPath << std::endl;
     }
     return 0;
 }